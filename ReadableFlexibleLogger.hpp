@@ -10,8 +10,10 @@
 #include <sstream>
 
 constexpr size_t FIXED_PAYLOAD_SIZE = 60;
+// Value written into an entry's validity field once its payload is persisted.
+constexpr uint16_t LOG_VALIDITY_MARKER = 0xBEEF;
 
-uint16_t computeFlexibleMeta(const char oldData[FIXED_PAYLOAD_SIZE], const char newData[FIXED_PAYLOAD_SIZE]) {
+inline uint16_t computeFlexibleMeta(const char oldData[FIXED_PAYLOAD_SIZE], const char newData[FIXED_PAYLOAD_SIZE]) {
     const int totalBits = FIXED_PAYLOAD_SIZE * 8;
     for (int i = FIXED_PAYLOAD_SIZE - 1; i >= 0; i--) {
         uint8_t diff = static_cast<uint8_t>(oldData[i]) ^ static_cast<uint8_t>(newData[i]);
@@ -30,7 +32,7 @@ uint16_t computeFlexibleMeta(const char oldData[FIXED_PAYLOAD_SIZE], const char
     return meta;
 }
 
-std::string decodeMeta(uint16_t meta) {
+inline std::string decodeMeta(uint16_t meta) {
     int offset = meta >> 1;
     int bitVal = meta & 1;
     std::stringstream ss;
@@ -1,13 +1,16 @@
 #include "cache_simulator.hpp"
 #include "persistent_data_structure.hpp"
+#include "line_bitmap.hpp"
+#include "simd_kernels.hpp"
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
 
 void benchmarkParallelFlush(CacheSimulator &cacheSim, bool useSkipOptimization, int numThreads) {
-    const size_t numLines = cacheSim.getCache().size();
+    const size_t numLines = cacheSim.getNumLines();
     std::atomic<size_t> currentIndex(0);
     auto worker = [&]() {
         while (true) {
@@ -26,8 +29,7 @@ void benchmarkParallelFlush(CacheSimulator &cacheSim, bool useSkipOptimization,
 
 void benchmarkRedundantFlush(CacheSimulator &cacheSim, bool useSkipOptimization) {
     size_t line = 0;
-    cacheSim.getCache()[line].dirty = true;
-    cacheSim.getCache()[line].skip = false;
+    cacheSim.setLineState(line, true, false);
     
     auto start = std::chrono::steady_clock::now();
     size_t performed = cacheSim.redundantFlushes(line, 10, useSkipOptimization);
@@ -50,6 +52,225 @@ void benchmarkPersistentCounter(CacheSimulator &cacheSim, bool useSkipOptimizati
               << duration << " ms, final value: " << counter.get() << std::endl;
 }
 
+void benchmarkPersistenceDomain(CacheSimulator &cacheSim, PersistenceDomain domain, const char *name) {
+    cacheSim.resetCache();
+    cacheSim.setPersistenceDomain(domain);
+    auto start = std::chrono::steady_clock::now();
+    {
+        PersistentCounter counter(cacheSim, 0);
+        for (int i = 0; i < 1000; ++i) {
+            counter.increment();
+            counter.persist(false);
+        }
+        counter.increment();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    cacheSim.simulateCrash();
+    std::cout << name << ": " << duration << " ms, flushes " << cacheSim.getStats().flushCount
+              << ", elided " << cacheSim.getStats().flushesElided
+              << ", value after crash " << cacheSim.peekLine(0) << " (last unflushed write: 1001)" << std::endl;
+    cacheSim.setPersistenceDomain(PersistenceDomain::ADR);
+}
+
+// Writes small records (4-byte ints and 12-byte fields) into every line and
+// flushes them with full-line or sub-line write-back.
+void benchmarkSubLineWriteback(CacheSimulator &cacheSim, bool subLine) {
+    cacheSim.resetCache();
+    cacheSim.setSubLineWriteback(subLine);
+    const size_t numLines = cacheSim.getNumLines();
+    for (size_t i = 0; i < numLines; ++i) {
+        if (i % 2 == 0)
+            cacheSim.writeLine(i, static_cast<int>(i));
+        else
+            cacheSim.writeLine(i, static_cast<int>(i), 20, 12);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numLines; ++i)
+        cacheSim.flushLine(i, false);
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    auto &stats = cacheSim.getStats();
+    std::cout << (subLine ? "Sub-line" : "Full-line") << " write-back: " << duration << " ms, "
+              << stats.bytesWrittenBack << " bytes written back for " << stats.flushCount << " flushes" << std::endl;
+    cacheSim.setSubLineWriteback(false);
+}
+
+// Writes every line, persists it, then rewrites the same values and persists
+// again; with silent-store elimination the second round needs no flushes.
+// Each run gets a fresh cache: resetCache keeps line values as persisted, so
+// a reused cache would start with the values already durable. Values start
+// at 1 so none matches the initial persisted 0.
+void benchmarkSilentStores(size_t numLines, bool eliminate) {
+    CacheSimulator cacheSim(numLines);
+    cacheSim.setSilentStoreElimination(eliminate);
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < numLines; ++i)
+            cacheSim.writeLine(i, static_cast<int>(i) * 3 + 1);
+        for (size_t i = 0; i < numLines; ++i)
+            cacheSim.flushLine(i, true);
+        cacheSim.memoryFence();
+    }
+    auto &stats = cacheSim.getStats();
+    std::cout << (eliminate ? "With" : "Without") << " silent-store elimination: " << stats.flushCount
+              << " flushes, " << stats.silentStoresEliminated << " silent stores eliminated" << std::endl;
+}
+
+// Each round rewrites only the first eighth of the lines but flushes all of
+// them, leaving the predictor to learn which flushes are redundant.
+void benchmarkSkipPredictor(CacheSimulator &cacheSim, int rounds) {
+    cacheSim.resetCache();
+    const size_t numLines = cacheSim.getNumLines();
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < numLines / 8; ++i)
+            cacheSim.writeLine(i, round);
+        for (size_t i = 0; i < numLines; ++i)
+            cacheSim.flushLine(i);
+        cacheSim.memoryFence();
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    auto &stats = cacheSim.getStats();
+    std::cout << "Skip predictor: " << duration << " ms, " << stats.flushCount << " flushes, "
+              << stats.redundantFlushesSkipped << " skipped, accuracy " << stats.skipPredictionsCorrect
+              << "/" << stats.skipPredictions << " (" << stats.wastedFlushes << " wasted flushes, "
+              << stats.mispredictedSkips << " mispredicted skips)" << std::endl;
+}
+
+// PersistentCounter-style hot line: flushed after every increment, fenced
+// every 50 increments.
+void benchmarkFlushCoalescing(CacheSimulator &cacheSim, unsigned windowMicros, int iterations) {
+    cacheSim.resetCache();
+    cacheSim.setFlushCoalescingWindow(windowMicros);
+    PersistentCounter counter(cacheSim, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 1; i <= iterations; ++i) {
+        counter.increment();
+        cacheSim.flushLine(0, true);
+        if (i % 50 == 0)
+            cacheSim.memoryFence();
+    }
+    cacheSim.memoryFence();
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    auto &stats = cacheSim.getStats();
+    std::cout << "Coalescing window " << windowMicros << " us: " << duration << " ms, "
+              << stats.flushCount << " physical flushes, " << stats.flushesCoalesced << " coalesced" << std::endl;
+    cacheSim.setFlushCoalescingWindow(0);
+}
+
+// Compares finding dirty lines by scanning every CacheLine's dirty flag with
+// the bitmap-driven flushAllDirty and resetCache.
+void benchmarkDirtyTracking(size_t numLines, size_t dirtyCount) {
+    CacheSimulator bigCache(numLines);
+    bigCache.setFlushLatency(0);
+    for (size_t i = 0; i < dirtyCount; ++i)
+        bigCache.writeLine((i * 7919 * 64) % numLines, static_cast<int>(i) + 1);
+
+    // Reads the line pages directly, one page lookup per LINES_PER_PAGE
+    // lines, so the baseline pays for the struct scan and not per-line locking.
+    auto start = std::chrono::steady_clock::now();
+    size_t scanned = 0;
+    for (size_t first = 0; first < numLines; first += LINES_PER_PAGE) {
+        const auto *lines = static_cast<const CacheLine *>(bigCache.getLineStorage(first));
+        size_t count = std::min(LINES_PER_PAGE, numLines - first);
+        for (size_t i = 0; lines && i < count; ++i)
+            scanned += lines[i].dirty ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto scanMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    size_t flushed = bigCache.flushAllDirty();
+    end = std::chrono::steady_clock::now();
+    auto flushMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    start = std::chrono::steady_clock::now();
+    bigCache.resetCache();
+    end = std::chrono::steady_clock::now();
+    auto resetMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    std::cout << numLines << " lines, " << scanned << " dirty: CacheLine scan " << scanMicros << " us, flushAllDirty ("
+              << flushed << " flushes) " << flushMicros << " us, resetCache " << resetMicros << " us" << std::endl;
+}
+
+// Times the bulk bitmap passes behind memoryFence and getDirtyLineCount on a
+// bitmap covering `numBits` lines with every third line set.
+void benchmarkBitmapKernels(size_t numBits) {
+    LineBitmap bitmap(numBits);
+    for (size_t i = 0; i < numBits; i += 3)
+        bitmap.set(i);
+    const int passes = 20;
+    auto start = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (int p = 0; p < passes; ++p)
+        total += bitmap.count();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(numBits / 8) * passes / (1024.0 * 1024.0);
+    std::cout << "Kernels: " << simdKernelName() << ", count() " << total / passes << " set bits at "
+              << megabytes / seconds << " MB/s" << std::endl;
+
+    bitmap.clearAll();
+    start = std::chrono::steady_clock::now();
+    bool found = false;
+    for (int p = 0; p < passes; ++p)
+        found = found || bitmap.any();
+    end = std::chrono::steady_clock::now();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::cout << "any() on an empty bitmap: " << (found ? "set" : "clear") << ", "
+              << micros / passes << " us per pass" << std::endl;
+}
+
+// Touches scattered runs of 64 consecutive lines in a 256 GiB address space
+// held in sparse storage; only the pages those runs fall into are allocated.
+void benchmarkSparseStorage(size_t numLines, size_t touches) {
+    auto start = std::chrono::steady_clock::now();
+    CacheSimulator sparseCache(numLines, LineStorage::Sparse);
+    sparseCache.setFlushLatency(0);
+    for (size_t i = 0; i < touches; ++i)
+        sparseCache.writeLine(((i / 64) * 2654435761u * LINES_PER_PAGE + i % 64) % numLines, static_cast<int>(i) + 1);
+    size_t flushed = sparseCache.flushAllDirty();
+    // Reading untouched lines must not allocate their pages.
+    for (size_t i = 0; i < touches; ++i)
+        sparseCache.readLine((numLines / 2 + i * LINES_PER_PAGE) % numLines);
+    sparseCache.memoryFence();
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    double denseMiB = static_cast<double>(numLines) * sizeof(CacheLine) / (1024.0 * 1024.0);
+    std::cout << numLines << " lines (" << (numLines * CACHE_LINE_SIZE >> 30) << " GiB), " << touches
+              << " lines written and " << flushed << " flushed in " << duration << " ms: "
+              << sparseCache.getAllocatedPages() << " pages allocated, "
+              << sparseCache.getResidentBytes() / (1024 * 1024) << " MiB resident (dense storage would need "
+              << static_cast<size_t>(denseMiB) << " MiB)" << std::endl;
+}
+
+// Builds a dense cache under the given huge-page policy and then writes
+// random lines, so both the construction cost and the TLB reach of the line
+// pages show up.
+void benchmarkHugePages(size_t numLines, HugePageMode mode, bool prefault) {
+    setHugePagePolicy(mode, prefault);
+    size_t hugeBefore = residentHugePageBytes();
+    auto start = std::chrono::steady_clock::now();
+    CacheSimulator bigCache(numLines);
+    auto built = std::chrono::steady_clock::now();
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < 1000000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        bigCache.writeLine(state % numLines, static_cast<int>(i));
+    }
+    auto end = std::chrono::steady_clock::now();
+    size_t hugeBytes = residentHugePageBytes() - std::min(hugeBefore, residentHugePageBytes());
+    std::cout << hugePageModeName(mode) << (prefault ? " + prefault" : "") << ": construct "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count() << " ms, 1M random writes "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - built).count() << " ms, "
+              << hugeBytes / (1024 * 1024) << " MiB in huge pages" << std::endl;
+    setHugePagePolicy(HugePageMode::Off, false);
+}
+
 int main() {
     const size_t cacheSize = 1024;
     CacheSimulator cacheSim(cacheSize);
@@ -58,8 +279,7 @@ int main() {
     std::cout << "=== Benchmark: Parallel Flush ===" << std::endl;
     cacheSim.resetCache();
     for (size_t i = 0; i < cacheSize; ++i) {
-        cacheSim.getCache()[i].dirty = true;
-        cacheSim.getCache()[i].skip = false;
+        cacheSim.setLineState(i, true, false);
     }
     auto start = std::chrono::steady_clock::now();
     benchmarkParallelFlush(cacheSim, false, numThreads);
@@ -69,8 +289,7 @@ int main() {
 
     cacheSim.resetCache();
     for (size_t i = 0; i < cacheSize; ++i) {
-        cacheSim.getCache()[i].dirty = false;
-        cacheSim.getCache()[i].skip = true;
+        cacheSim.setLineState(i, false, true);
     }
     start = std::chrono::steady_clock::now();
     benchmarkParallelFlush(cacheSim, true, numThreads);
@@ -84,8 +303,7 @@ int main() {
     benchmarkRedundantFlush(cacheSim, false);
     cacheSim.resetCache();
     std::cout << "With skip optimization:" << std::endl;
-    cacheSim.getCache()[0].dirty = false;
-    cacheSim.getCache()[0].skip = true;
+    cacheSim.setLineState(0, false, true);
     benchmarkRedundantFlush(cacheSim, true);
 
     std::cout << "\n=== Benchmark: Persistent Counter Workload ===" << std::endl;
@@ -96,5 +314,38 @@ int main() {
     std::cout << "With skip optimization:" << std::endl;
     benchmarkPersistentCounter(cacheSim, true, 1000);
 
+    std::cout << "\n=== Benchmark: Persistence Domain ===" << std::endl;
+    benchmarkPersistenceDomain(cacheSim, PersistenceDomain::ADR, "ADR");
+    benchmarkPersistenceDomain(cacheSim, PersistenceDomain::EADR, "eADR");
+
+    std::cout << "\n=== Benchmark: Sub-Line Write-Back ===" << std::endl;
+    benchmarkSubLineWriteback(cacheSim, false);
+    benchmarkSubLineWriteback(cacheSim, true);
+
+    std::cout << "\n=== Benchmark: Adaptive Skip Predictor ===" << std::endl;
+    benchmarkSkipPredictor(cacheSim, 8);
+
+    std::cout << "\n=== Benchmark: Flush Coalescing ===" << std::endl;
+    benchmarkFlushCoalescing(cacheSim, 0, 1000);
+    benchmarkFlushCoalescing(cacheSim, 500, 1000);
+
+    std::cout << "\n=== Benchmark: Silent Stores ===" << std::endl;
+    benchmarkSilentStores(cacheSize, false);
+    benchmarkSilentStores(cacheSize, true);
+
+    std::cout << "\n=== Benchmark: Dirty-Line Bitmap ===" << std::endl;
+    benchmarkDirtyTracking(size_t(1) << 22, 256);
+    benchmarkBitmapKernels(size_t(1) << 28);
+
+    std::cout << "\n=== Benchmark: Sparse Line Storage ===" << std::endl;
+    benchmarkSparseStorage(size_t(1) << 32, 10000);
+
+    std::cout << "\n=== Benchmark: Huge-Page Backed Lines ===" << std::endl;
+    benchmarkHugePages(size_t(1) << 24, HugePageMode::Off, false);
+    benchmarkHugePages(size_t(1) << 24, HugePageMode::Transparent, false);
+    benchmarkHugePages(size_t(1) << 24, HugePageMode::Transparent, true);
+    benchmarkHugePages(size_t(1) << 24, HugePageMode::Explicit, false);
+    std::cout << "hugetlb fallbacks to THP: " << getHugePageStats().hugetlbFallbacks << std::endl;
+
     return 0;
 }
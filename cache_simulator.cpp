@@ -1,22 +1,115 @@
 #include "cache_simulator.hpp"
+#include "memory_controller.hpp"
+#include "persistency_tracker.hpp"
+#include "flush_scheduler.hpp"
+#include "sim_timing.hpp"
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
 
-CacheSimulator::CacheSimulator(size_t numLines)
-    : cacheLines(numLines), flushLatency(100), cleanLatency(50), readLatency(10) {}
+PersistenceDomain persistenceDomainFromString(const std::string &name) {
+    std::string upper(name);
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+    if (upper == "ADR")
+        return PersistenceDomain::ADR;
+    if (upper == "EADR")
+        return PersistenceDomain::EADR;
+    throw std::invalid_argument("Unknown persistence domain: " + name);
+}
+
+CacheSimulator::CacheSimulator(size_t numLines, LineStorage storage)
+    : numLines(numLines), pages((numLines + LINES_PER_PAGE - 1) / LINES_PER_PAGE), allocatedPages(0), dirtyLines(numLines), pendingLines(numLines), touchedLines(numLines), flushLatency(100), cleanLatency(50), readLatency(10), subLineWriteback(false), silentStoreElimination(false), coalescingWindow(0), simulatedTime(0), memoryController(nullptr), flushScheduler(nullptr), persistenceDomain(PersistenceDomain::ADR), timingModel(TimingModel::Sleep) {
+    if (storage == LineStorage::Dense) {
+        lineArena.reserve(pages.size() * LINES_PER_PAGE * sizeof(CacheLine));
+        for (size_t page = 0; page < pages.size(); ++page)
+            lineAt(page * LINES_PER_PAGE);
+    }
+}
+
+// Returns the line, allocating its page on first use. Called with cacheMutex
+// held (or from the constructor).
+CacheLine& CacheSimulator::lineAt(size_t index) {
+    CacheLine *&page = pages[index / LINES_PER_PAGE];
+    if (!page) {
+        page = static_cast<CacheLine *>(lineArena.allocate(LINES_PER_PAGE * sizeof(CacheLine), alignof(CacheLine)));
+        for (size_t i = 0; i < LINES_PER_PAGE; ++i)
+            new (&page[i]) CacheLine();
+        allocatedPages++;
+    }
+    return page[index % LINES_PER_PAGE];
+}
+
+// Returns the line, or nullptr if its page was never allocated, in which case
+// the line is clean and holds 0.
+const CacheLine* CacheSimulator::findLine(size_t index) const {
+    const CacheLine *page = pages[index / LINES_PER_PAGE];
+    return page ? &page[index % LINES_PER_PAGE] : nullptr;
+}
+
+static size_t dirtyBytes(const CacheLine &line) {
+    if (!line.dirty)
+        return 0;
+    if (line.dirtyMask == 0)
+        return CACHE_LINE_SIZE;
+    return static_cast<size_t>(__builtin_popcount(line.dirtyMask)) * CACHE_SECTOR_SIZE;
+}
+
+// Keeps the dirty bitmap in step with the line's dirty bit. Called with
+// cacheMutex held.
+void CacheSimulator::setDirty(size_t index, bool dirty) {
+    lineAt(index).dirty = dirty;
+    dirtyLines.assign(index, dirty);
+    touchedLines.set(index);
+}
 
 void CacheSimulator::writeLine(size_t index, int value) {
+    writeLine(index, value, 0, sizeof(int));
+}
+
+void CacheSimulator::writeLine(size_t index, int value, size_t offset, size_t length) {
+    if (length == 0 || offset >= CACHE_LINE_SIZE || length > CACHE_LINE_SIZE - offset)
+        throw std::out_of_range("Store of " + std::to_string(length) + " bytes at offset " + std::to_string(offset) +
+                                " does not fit in a cache line");
     std::lock_guard<std::mutex> lock(cacheMutex);
-    cacheLines[index].data = value;
-    cacheLines[index].dirty = true;
-    cacheLines[index].skip = false;
+    auto &line = lineAt(index);
+    int persistedValue = persistenceDomain == PersistenceDomain::EADR ? line.data : line.persistedData;
+    if (silentStoreElimination && value == persistedValue && !line.pendingFlush.load()) {
+        // The line already matches what is persisted, so no flush is needed.
+        line.data = value;
+        setDirty(index, false);
+        line.dirtyMask = 0;
+        line.skip = true;
+        if (persistencyTracker)
+            persistencyTracker->onSilentStore(index);
+        stats.silentStoresEliminated++;
+        return;
+    }
+    size_t last = offset + length - 1;
+    for (size_t sector = offset / CACHE_SECTOR_SIZE; sector <= last / CACHE_SECTOR_SIZE; ++sector)
+        line.dirtyMask |= static_cast<uint8_t>(1u << sector);
+    line.data = value;
+    setDirty(index, true);
+    line.skip = false;
+    if (persistencyTracker)
+        persistencyTracker->onStore(index);
+    if (persistObserver && persistenceDomain == PersistenceDomain::EADR)
+        persistObserver(index, value);
+}
+
+// Pays a latency under the timing model and advances the cache's clock.
+void CacheSimulator::charge(uint64_t microseconds) {
+    chargeLatency(timingModel, microseconds);
+    simulatedTime += microseconds;
 }
 
 int CacheSimulator::readLine(size_t index) {
-    std::this_thread::sleep_for(std::chrono::microseconds(readLatency));
+    charge(readLatency);
     std::lock_guard<std::mutex> lock(cacheMutex);
-    int value = cacheLines[index].data;
-    if (!cacheLines[index].dirty)
+    const CacheLine *line = findLine(index);
+    int value = line ? line->data : 0;
+    if (!line || !line->dirty)
         stats.readHits++;
     else
         stats.readMisses++;
@@ -25,39 +118,201 @@ int CacheSimulator::readLine(size_t index) {
 
 bool CacheSimulator::flushLine(size_t index, bool useSkipOptimization) {
     std::lock_guard<std::mutex> lock(cacheMutex);
-    auto &line = cacheLines[index];
+    drainExpiredFlushes(false);
+    auto &line = lineAt(index);
     if (line.pendingFlush.load()) return false;
     if (useSkipOptimization && !line.dirty && line.skip) {
         stats.redundantFlushesSkipped++;
         return false;
     }
+    if (persistenceDomain == PersistenceDomain::EADR) {
+        if (persistencyTracker)
+            persistencyTracker->onFlush(index, line.dirty);
+        setDirty(index, false);
+        line.dirtyMask = 0;
+        line.skip = true;
+        stats.flushesElided++;
+        return true;
+    }
+    if (coalescingWindow > 0) {
+        if (line.deferred != DeferredFlush::None) {
+            if (!useSkipOptimization)
+                line.deferred = DeferredFlush::Always;
+            stats.flushesCoalesced++;
+            return false;
+        }
+        line.deferred = useSkipOptimization ? DeferredFlush::SkipIfPersisted : DeferredFlush::Always;
+        touchedLines.set(index);
+        coalesceQueue.push_back({index, coalescingNow() + coalescingWindow});
+        return false;
+    }
+    performFlush(index);
+    return true;
+}
+
+// Issues the physical flush of one line. Called with cacheMutex held; the
+// lock is released while the flush latency elapses.
+void CacheSimulator::performFlush(size_t index) {
+    auto &line = lineAt(index);
+    bool wasDirty = line.dirty;
+    int flushedValue = line.data;
+    size_t bytes = subLineWriteback ? dirtyBytes(line) : (line.dirty ? CACHE_LINE_SIZE : 0);
     line.pendingFlush.store(true);
+    pendingLines.set(index);
     cacheMutex.unlock();
-    std::this_thread::sleep_for(std::chrono::microseconds(flushLatency));
+    unsigned latency = flushLatency;
+    bool submit = memoryController != nullptr;
+    if (subLineWriteback) {
+        latency = static_cast<unsigned>(flushLatency * std::max(bytes, CACHE_SECTOR_SIZE) / CACHE_LINE_SIZE);
+        submit = submit && bytes > 0;
+    }
+    unsigned stall = submit ? memoryController->submitFlush(index * CACHE_LINE_SIZE) : 0;
+    charge(latency + stall);
     cacheMutex.lock();
-    line.dirty = false;
+    setDirty(index, false);
+    line.dirtyMask = 0;
+    stats.bytesWrittenBack += bytes;
     line.skip = true;
+    line.persistedData = flushedValue;
+    if (persistencyTracker)
+        persistencyTracker->onFlush(index, wasDirty);
+    if (persistObserver)
+        persistObserver(index, flushedValue);
     line.pendingFlush.store(false);
+    pendingLines.reset(index);
     stats.flushCount++;
-    return true;
+}
+
+// Current time on the clock coalescing deadlines are measured on.
+uint64_t CacheSimulator::coalescingNow() const {
+    return coalescingClock ? coalescingClock() : simulatedTime.load();
+}
+
+void CacheSimulator::drainCoalescedFlushes(bool drainAll) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    drainExpiredFlushes(drainAll);
+}
+
+// Issues the deferred flushes whose deadline has passed, or all of them.
+// Called with cacheMutex held.
+void CacheSimulator::drainExpiredFlushes(bool drainAll) {
+    if (coalesceQueue.empty())
+        return;
+    if (drainAll && flushScheduler && coalesceQueue.size() > 1) {
+        // Everything queued sits between the same two fences, so it may be
+        // issued in whatever order the scheduler prefers.
+        std::vector<size_t> batch;
+        batch.reserve(coalesceQueue.size());
+        for (const auto &request : coalesceQueue)
+            batch.push_back(request.first);
+        coalesceQueue.clear();
+        for (size_t index : flushScheduler->schedule(batch))
+            drainDeferredFlush(index);
+        return;
+    }
+    while (!coalesceQueue.empty()) {
+        auto request = coalesceQueue.front();
+        if (!drainAll && request.second > coalescingNow())
+            break;
+        coalesceQueue.pop_front();
+        drainDeferredFlush(request.first);
+    }
+}
+
+// Issues a deferred flush against the line's state now, which may have
+// changed since the request (e.g. an eviction persisted it). Called with
+// cacheMutex held.
+void CacheSimulator::drainDeferredFlush(size_t index) {
+    auto &line = lineAt(index);
+    DeferredFlush deferred = line.deferred;
+    line.deferred = DeferredFlush::None;
+    if (deferred == DeferredFlush::None || line.pendingFlush.load())
+        return;
+    if (deferred == DeferredFlush::SkipIfPersisted && !line.dirty && line.skip) {
+        stats.redundantFlushesSkipped++;
+        return;
+    }
+    performFlush(index);
 }
 
 bool CacheSimulator::cleanLine(size_t index, bool useSkipOptimization) {
     std::lock_guard<std::mutex> lock(cacheMutex);
-    auto &line = cacheLines[index];
+    auto &line = lineAt(index);
     if (useSkipOptimization && !line.dirty && line.skip) {
         stats.redundantFlushesSkipped++;
         return false;
     }
+    if (persistenceDomain == PersistenceDomain::EADR) {
+        if (persistencyTracker)
+            persistencyTracker->onFlush(index, line.dirty);
+        setDirty(index, false);
+        line.dirtyMask = 0;
+        line.skip = true;
+        stats.flushesElided++;
+        return true;
+    }
+    bool wasDirty = line.dirty;
+    int cleanedValue = line.data;
+    size_t bytes = subLineWriteback ? dirtyBytes(line) : (line.dirty ? CACHE_LINE_SIZE : 0);
     cacheMutex.unlock();
-    std::this_thread::sleep_for(std::chrono::microseconds(cleanLatency));
+    unsigned latency = cleanLatency;
+    bool submit = memoryController != nullptr;
+    if (subLineWriteback) {
+        latency = static_cast<unsigned>(cleanLatency * std::max(bytes, CACHE_SECTOR_SIZE) / CACHE_LINE_SIZE);
+        submit = submit && bytes > 0;
+    }
+    unsigned stall = submit ? memoryController->submitFlush(index * CACHE_LINE_SIZE) : 0;
+    charge(latency + stall);
     cacheMutex.lock();
-    line.dirty = false;
+    setDirty(index, false);
+    line.dirtyMask = 0;
+    stats.bytesWrittenBack += bytes;
     line.skip = true;
+    line.persistedData = cleanedValue;
+    if (persistencyTracker)
+        persistencyTracker->onFlush(index, wasDirty);
+    if (persistObserver)
+        persistObserver(index, cleanedValue);
     stats.cleanCount++;
     return true;
 }
 
+// Predicts and then trains on the line's actual state, which the caller acts
+// on only through the prediction.
+bool CacheSimulator::predictSkip(size_t index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto &line = lineAt(index);
+    bool redundant = !line.dirty && line.skip;
+    bool predicted = line.skipCounter >= 2;
+    touchedLines.set(index);
+    stats.skipPredictions++;
+    if (predicted == redundant)
+        stats.skipPredictionsCorrect++;
+    else if (predicted)
+        stats.mispredictedSkips++;
+    else
+        stats.wastedFlushes++;
+    if (predicted && redundant)
+        stats.redundantFlushesSkipped++;
+    if (redundant && line.skipCounter < 3)
+        line.skipCounter++;
+    else if (!redundant && line.skipCounter > 0)
+        line.skipCounter--;
+    return predicted;
+}
+
+bool CacheSimulator::flushLine(size_t index) {
+    if (predictSkip(index))
+        return false;
+    return flushLine(index, false);
+}
+
+bool CacheSimulator::cleanLine(size_t index) {
+    if (predictSkip(index))
+        return false;
+    return cleanLine(index, false);
+}
+
 size_t CacheSimulator::redundantFlushes(size_t index, int count, bool useSkipOptimization) {
     size_t performed = 0;
     for (int i = 0; i < count; ++i) {
@@ -68,47 +323,139 @@ size_t CacheSimulator::redundantFlushes(size_t index, int count, bool useSkipOpt
 }
 
 void CacheSimulator::memoryFence() {
-    bool pending = true;
+    stats.fenceCount++;
+    drainCoalescedFlushes(true);
+    // Under eADR flushes complete immediately, so the fence only orders stores.
+    bool pending = persistenceDomain == PersistenceDomain::ADR;
     while (pending) {
         pending = false;
         {
             std::lock_guard<std::mutex> lock(cacheMutex);
-            for (auto &line : cacheLines) {
-                if (line.pendingFlush.load()) {
-                    pending = true;
-                    break;
-                }
-            }
+            pending = pendingLines.any();
         }
-        if (pending)
+        if (pending && timingModel == TimingModel::Sleep)
             std::this_thread::sleep_for(std::chrono::microseconds(10));
+        else if (pending)
+            std::this_thread::yield();
+    }
+    if (persistencyTracker) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        persistencyTracker->onFence();
     }
 }
 
 void CacheSimulator::evictLine(size_t index) {
     std::lock_guard<std::mutex> lock(cacheMutex);
-    cacheLines[index].dirty = false;
-    cacheLines[index].skip = false;
+    lineAt(index).persistedData = lineAt(index).data;
+    if (persistObserver)
+        persistObserver(index, lineAt(index).data);
+    if (persistencyTracker)
+        persistencyTracker->onEvict(index);
+    setDirty(index, false);
+    lineAt(index).dirtyMask = 0;
+    lineAt(index).skip = false;
     stats.evictionCount++;
 }
 
 void CacheSimulator::resetCache() {
     std::lock_guard<std::mutex> lock(cacheMutex);
-    for (auto &line : cacheLines) {
+    // Lines never touched since the last reset are already in their reset state.
+    touchedLines.forEach([&](size_t index) {
+        auto &line = lineAt(index);
         line.dirty = false;
+        line.dirtyMask = 0;
         line.skip = false;
+        line.skipCounter = 1;
+        line.deferred = DeferredFlush::None;
+        line.persistedData = line.data;
         line.pendingFlush.store(false);
-    }
+    });
+    dirtyLines.clearAll();
+    pendingLines.clearAll();
+    touchedLines.clearAll();
     stats.flushCount = 0;
     stats.cleanCount = 0;
     stats.evictionCount = 0;
     stats.redundantFlushesSkipped = 0;
     stats.readHits = 0;
     stats.readMisses = 0;
+    stats.flushesElided = 0;
+    stats.fenceCount = 0;
+    stats.bytesWrittenBack = 0;
+    stats.silentStoresEliminated = 0;
+    stats.skipPredictions = 0;
+    stats.skipPredictionsCorrect = 0;
+    stats.mispredictedSkips = 0;
+    stats.wastedFlushes = 0;
+    stats.flushesCoalesced = 0;
+    coalesceQueue.clear();
+    if (persistencyTracker)
+        persistencyTracker->reset();
+}
+
+size_t CacheSimulator::getNumLines() const {
+    return numLines;
+}
+
+uint64_t CacheSimulator::getSimulatedTime() const {
+    return simulatedTime.load();
+}
+
+int CacheSimulator::peekLine(size_t index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    const CacheLine *line = findLine(index);
+    return line ? line->data : 0;
 }
 
-std::vector<CacheLine>& CacheSimulator::getCache() {
-    return cacheLines;
+bool CacheSimulator::isLineDirty(size_t index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return dirtyLines.test(index);
+}
+
+size_t CacheSimulator::getAllocatedPages() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return allocatedPages;
+}
+
+const void* CacheSimulator::getLineStorage(size_t index) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return findLine(index);
+}
+
+size_t CacheSimulator::getResidentBytes() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return allocatedPages * LINES_PER_PAGE * sizeof(CacheLine) + pages.size() * sizeof(pages[0]) +
+           dirtyLines.allocatedBytes() + pendingLines.allocatedBytes() + touchedLines.allocatedBytes();
+}
+
+void CacheSimulator::setLineState(size_t index, bool dirty, bool skip) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!dirty && !skip && !findLine(index))
+        return; // already the state of an unallocated line
+    setDirty(index, dirty);
+    lineAt(index).dirtyMask = 0;
+    lineAt(index).skip = skip;
+}
+
+size_t CacheSimulator::getDirtyLineCount() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return dirtyLines.count();
+}
+
+std::vector<size_t> CacheSimulator::getDirtyLines() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::vector<size_t> result;
+    dirtyLines.forEach([&](size_t index) { result.push_back(index); });
+    return result;
+}
+
+size_t CacheSimulator::flushAllDirty() {
+    size_t performed = 0;
+    for (size_t index : getDirtyLines()) {
+        if (flushLine(index, false))
+            performed++;
+    }
+    return performed;
 }
 
 CacheStats& CacheSimulator::getStats() {
@@ -126,3 +473,104 @@ void CacheSimulator::setCleanLatency(unsigned microseconds) {
 void CacheSimulator::setReadLatency(unsigned microseconds) {
     readLatency = microseconds;
 }
+
+void CacheSimulator::setTimingModel(TimingModel model) {
+    timingModel = model;
+}
+
+void CacheSimulator::setSubLineWriteback(bool enabled) {
+    subLineWriteback = enabled;
+}
+
+void CacheSimulator::setSilentStoreElimination(bool enabled) {
+    silentStoreElimination = enabled;
+}
+
+void CacheSimulator::setFlushCoalescingWindow(unsigned microseconds) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (microseconds == 0)
+        drainExpiredFlushes(true);
+    coalescingWindow = microseconds;
+}
+
+void CacheSimulator::setCoalescingClock(std::function<uint64_t()> clock) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    coalescingClock = std::move(clock);
+}
+
+void CacheSimulator::setFlushScheduler(FlushScheduler *scheduler) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    flushScheduler = scheduler;
+}
+
+void CacheSimulator::setMemoryController(MemoryController *controller) {
+    memoryController = controller;
+}
+
+void CacheSimulator::setPersistenceDomain(PersistenceDomain domain) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    persistenceDomain = domain;
+}
+
+PersistenceDomain CacheSimulator::getPersistenceDomain() const {
+    return persistenceDomain;
+}
+
+std::vector<int> CacheSimulator::getPersistedImage() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    std::vector<int> image;
+    image.reserve(numLines);
+    for (size_t index = 0; index < numLines; ++index) {
+        const CacheLine *line = findLine(index);
+        if (!line)
+            image.push_back(0);
+        else
+            image.push_back(persistenceDomain == PersistenceDomain::EADR ? line->data : line->persistedData);
+    }
+    return image;
+}
+
+void CacheSimulator::simulateCrash() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    touchedLines.forEach([&](size_t index) {
+        auto &line = lineAt(index);
+        if (persistenceDomain == PersistenceDomain::EADR)
+            line.persistedData = line.data;
+        else
+            line.data = line.persistedData;
+        line.dirty = false;
+        line.dirtyMask = 0;
+        line.skip = false;
+        line.deferred = DeferredFlush::None;
+        line.pendingFlush.store(false);
+    });
+    dirtyLines.clearAll();
+    pendingLines.clearAll();
+    coalesceQueue.clear();
+}
+
+void CacheSimulator::setPersistObserver(PersistObserver observer) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    persistObserver = std::move(observer);
+}
+
+void CacheSimulator::setPersistencyTracking(bool enabled) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!enabled)
+        persistencyTracker.reset();
+    else if (!persistencyTracker)
+        persistencyTracker = std::make_unique<PersistencyTracker>();
+}
+
+void CacheSimulator::requirePersistOrder(size_t before, size_t after) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (persistencyTracker)
+        persistencyTracker->requirePersistOrder(before, after);
+}
+
+PersistencyReport CacheSimulator::getPersistencyReport() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!persistencyTracker)
+        return PersistencyReport{0, 0, 0, 0, {}};
+    return persistencyTracker->report(persistenceDomain == PersistenceDomain::EADR);
+}
@@ -2,15 +2,58 @@
 #include <vector>
 #include <mutex>
 #include <atomic>
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <memory>
+#include <deque>
+#include "persistency_tracker.hpp"
+#include "line_bitmap.hpp"
+#include "huge_page_allocator.hpp"
+#include "sim_timing.hpp"
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+// Dirty state is tracked per 8-byte word within a line.
+constexpr size_t CACHE_SECTOR_SIZE = 8;
+constexpr size_t SECTORS_PER_LINE = CACHE_LINE_SIZE / CACHE_SECTOR_SIZE;
+
+// Lines are stored in pages of this many lines (see LineStorage).
+constexpr size_t LINES_PER_PAGE = 4096;
+
+// Dense storage allocates every page up front. Sparse storage allocates a
+// page the first time one of its lines changes state, so a huge, mostly
+// untouched address space costs only its page table and bitmap summaries.
+enum class LineStorage { Dense, Sparse };
+
+class MemoryController;
+class FlushScheduler;
+
+// Where the persistence domain begins. Under ADR only the memory controller's
+// WPQ survives power loss, so dirty lines must be flushed. Under eADR the CPU
+// caches are flushed by the platform on power loss, so flushes are unnecessary
+// and fences only order stores.
+enum class PersistenceDomain { ADR, EADR };
+
+// Parses "ADR" or "eADR" (case-insensitive); throws std::invalid_argument otherwise.
+PersistenceDomain persistenceDomainFromString(const std::string &name);
+
+// A flush deferred by the coalescing window. SkipIfPersisted is re-checked
+// against the skip bit when it drains; Always is issued regardless.
+enum class DeferredFlush : uint8_t { None, SkipIfPersisted, Always };
 
 // A simple structure to represent a cache line.
 struct CacheLine {
     bool dirty;
     bool skip;
     int data;
+    int persistedData; // value that has reached the persistence domain
+    uint8_t dirtyMask; // one bit per modified sector; empty while dirty means the whole line
+    uint8_t skipCounter; // 2-bit saturating counter: >= 2 predicts the next flush is redundant
+    DeferredFlush deferred; // flush waiting in the coalescing window, if any
     std::atomic<bool> pendingFlush;
 
-    CacheLine() : dirty(false), skip(false), data(0), pendingFlush(false) {}
+    CacheLine() : dirty(false), skip(false), data(0), persistedData(0), dirtyMask(0), skipCounter(1), deferred(DeferredFlush::None),
+                  pendingFlush(false) {}
 };
 
 struct CacheStats {
@@ -20,33 +63,156 @@ struct CacheStats {
     std::atomic<size_t> redundantFlushesSkipped;
     std::atomic<size_t> readHits;
     std::atomic<size_t> readMisses;
+    std::atomic<size_t> flushesElided; // flushes/cleans made unnecessary by eADR
+    std::atomic<size_t> fenceCount;
+    std::atomic<size_t> bytesWrittenBack; // modified bytes actually written back by flushes and cleans
+    std::atomic<size_t> silentStoresEliminated; // stores that left the line matching its persisted value
+    std::atomic<size_t> skipPredictions;
+    std::atomic<size_t> skipPredictionsCorrect;
+    std::atomic<size_t> mispredictedSkips; // predicted redundant, but the line was dirty: its persist was lost
+    std::atomic<size_t> wastedFlushes;     // predicted necessary, but the line was already persisted
+    std::atomic<size_t> flushesCoalesced;  // flush requests merged into an already deferred flush
 
-    CacheStats() : flushCount(0), cleanCount(0), evictionCount(0), redundantFlushesSkipped(0), readHits(0), readMisses(0) {}
+    CacheStats() : flushCount(0), cleanCount(0), evictionCount(0), redundantFlushesSkipped(0), readHits(0), readMisses(0),
+                   flushesElided(0), fenceCount(0), bytesWrittenBack(0), silentStoresEliminated(0),
+                   skipPredictions(0), skipPredictionsCorrect(0), mispredictedSkips(0), wastedFlushes(0),
+                   flushesCoalesced(0) {}
 };
 
 class CacheSimulator {
 public:
-    CacheSimulator(size_t numLines);
+    CacheSimulator(size_t numLines, LineStorage storage = LineStorage::Dense);
     
     void writeLine(size_t index, int value);
+    // Store of `length` bytes at `offset` within the line; only the sectors it
+    // covers are marked dirty. Throws std::out_of_range unless 0 < length and
+    // offset + length <= CACHE_LINE_SIZE.
+    void writeLine(size_t index, int value, size_t offset, size_t length);
     int readLine(size_t index);
+    // Returns whether a flush was issued; one deferred by the coalescing
+    // window is not issued yet and returns false.
+    // A line on a page never allocated (see LineStorage::Sparse) behaves like
+    // a never-written Dense line: its skip bit is clear, so the flush or clean
+    // is issued and charged, and its page is allocated to record the result.
     bool flushLine(size_t index, bool useSkipOptimization);
     bool cleanLine(size_t index, bool useSkipOptimization);
+    // Let the built-in skip predictor stand in for the skip-bit check: a
+    // predicted skip issues nothing and a predicted flush is issued
+    // unconditionally. A mispredicted skip leaves a dirty line unpersisted
+    // until its next flush (counted in mispredictedSkips), so use these only
+    // where that is acceptable, e.g. to evaluate the predictor.
+    bool flushLine(size_t index);
+    bool cleanLine(size_t index);
     size_t redundantFlushes(size_t index, int count, bool useSkipOptimization);
     void memoryFence();
     void evictLine(size_t index);
     void resetCache();
-    std::vector<CacheLine>& getCache();
+    size_t getNumLines() const;
+    // Microseconds of read, flush and clean latency this cache has charged,
+    // under either timing model. Coalescing windows are measured on it by
+    // default, so they do not depend on host speed.
+    uint64_t getSimulatedTime() const;
+    // Current value of a line, without read latency or statistics.
+    int peekLine(size_t index);
+    bool isLineDirty(size_t index);
+    size_t getAllocatedPages();
+    // Memory backing a line, or nullptr if its page is not allocated; used to
+    // report which NUMA node a cache's state landed on.
+    const void* getLineStorage(size_t index);
+    // Memory held by allocated pages, the page table and the line bitmaps.
+    size_t getResidentBytes();
+    // Forces a line's dirty and skip bits, e.g. to prepare a benchmark phase.
+    void setLineState(size_t index, bool dirty, bool skip);
+    size_t getDirtyLineCount();
+    // Snapshot of the dirty lines in ascending order, found through the dirty
+    // bitmap without scanning clean lines.
+    std::vector<size_t> getDirtyLines();
+    // Flushes every dirty line in address order; returns the flushes issued.
+    size_t flushAllDirty();
     CacheStats& getStats();
     void setFlushLatency(unsigned microseconds);
     void setCleanLatency(unsigned microseconds);
     void setReadLatency(unsigned microseconds);
+    // Sleep (default) blocks the caller for each latency; Accumulate charges
+    // it to the calling thread's total (see consumeChargedLatency) instead.
+    void setTimingModel(TimingModel model);
+    // When enabled, flushes and cleans are charged in proportion to the dirty
+    // sectors they write back instead of a full line.
+    void setSubLineWriteback(bool enabled);
+    // When enabled, a store of the value the line already holds in the
+    // persistence domain leaves the line clean, so no flush is needed for it.
+    void setSilentStoreElimination(bool enabled);
+    // When non-zero, flushLine defers the physical flush of a line for at
+    // least this many microseconds of the coalescing clock (see
+    // setCoalescingClock); further flush requests for the line in that window
+    // are merged into it. Expired flushes are issued by this cache's next
+    // flushLine or memoryFence, so a flush waits at most until the later of
+    // its deadline and that call. 0 disables and issues everything deferred.
+    void setFlushCoalescingWindow(unsigned microseconds);
+    // Clock coalescing deadlines are measured on, in simulated microseconds.
+    // Defaults to getSimulatedTime(), which only advances when this cache
+    // charges latency; caches replayed against a shared clock should pass it.
+    // Called under the cache lock, so it must not call back into this cache.
+    void setCoalescingClock(std::function<uint64_t()> clock);
+    // Reorders the deferred flushes a memoryFence drains (see
+    // setFlushCoalescingWindow) before they are issued. Pass nullptr for caller order.
+    void setFlushScheduler(FlushScheduler *scheduler);
+    // Routes flushed and cleaned lines through a shared memory-controller model
+    // instead of charging only the flat flush latency. Pass nullptr to detach.
+    void setMemoryController(MemoryController *controller);
+    void setPersistenceDomain(PersistenceDomain domain);
+    PersistenceDomain getPersistenceDomain() const;
+    // Values each line would hold after power loss in the current domain.
+    std::vector<int> getPersistedImage();
+    // Simulates power loss and restart: every line reverts to its persisted
+    // value and comes back clean.
+    void simulateCrash();
+    // Invoked (under the cache lock) every time a line value reaches the
+    // persistence domain, in the order it happens.
+    using PersistObserver = std::function<void(size_t index, int value)>;
+    void setPersistObserver(PersistObserver observer);
+    // Instrumentation mode that records store/flush/fence order per thread and
+    // reports missing flushes, redundant flushes and unordered persists.
+    void setPersistencyTracking(bool enabled);
+    // Declares that `after` may only persist once `before` is flushed and fenced
+    // (ignored unless tracking is enabled).
+    void requirePersistOrder(size_t before, size_t after);
+    PersistencyReport getPersistencyReport();
 
 private:
-    std::vector<CacheLine> cacheLines;
+    void charge(uint64_t microseconds);
+    bool predictSkip(size_t index);
+    void performFlush(size_t index);
+    uint64_t coalescingNow() const;
+    void drainCoalescedFlushes(bool drainAll);
+    void drainExpiredFlushes(bool drainAll);
+    void drainDeferredFlush(size_t index);
+    void setDirty(size_t index, bool dirty);
+    CacheLine& lineAt(size_t index);
+    const CacheLine* findLine(size_t index) const;
+
+    size_t numLines;
+    HugePageArena lineArena; // backs the line pages; see setHugePagePolicy
+    std::vector<CacheLine *> pages;
+    size_t allocatedPages;
+    LineBitmap dirtyLines;
+    LineBitmap pendingLines; // flushes in flight, scanned by memoryFence
+    LineBitmap touchedLines; // lines whose state may differ from the reset state
     std::mutex cacheMutex;
     CacheStats stats;
     unsigned flushLatency;
     unsigned cleanLatency;
     unsigned readLatency;
+    bool subLineWriteback;
+    bool silentStoreElimination;
+    unsigned coalescingWindow;
+    std::deque<std::pair<size_t, uint64_t>> coalesceQueue; // (line, simulated deadline)
+    std::function<uint64_t()> coalescingClock;
+    std::atomic<uint64_t> simulatedTime;
+    MemoryController *memoryController;
+    FlushScheduler *flushScheduler;
+    PersistenceDomain persistenceDomain;
+    TimingModel timingModel;
+    PersistObserver persistObserver;
+    std::unique_ptr<PersistencyTracker> persistencyTracker;
 };
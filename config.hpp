@@ -14,11 +14,29 @@ struct Config {
     int numThreads;
     int numCores;
     int simulationDuration; // in milliseconds
+    size_t nvmWpqEntries;
+    unsigned nvmBandwidthMBps; // bytes per simulated microsecond, per DIMM
+    size_t nvmChannels;
+    size_t nvmDimmsPerChannel;
+    size_t nvmInterleaveBytes;
+    std::string persistenceDomain; // "ADR" or "eADR"
+    unsigned flushCoalescingWindow; // microseconds, 0 disables
+    bool skipPredictor; // trace replays let the skip predictor decide flushes
+    std::string hugePages; // "off", "thp" or "hugetlb"
+    bool prefaultMemory;
+    bool pinThreads; // pin each simulated core's thread to a host CPU
+    std::string numaPlacement; // "spread" or "compact"
+    std::string coreScheduler; // "threads" (one host thread per core) or "tasks"
+    size_t schedulerWorkers; // host threads for "tasks", 0 = one per host CPU
 
     static Config loadFromFile(const std::string &filename) {
         std::ifstream inFile(filename);
         json j;
         inFile >> j;
+        return fromJson(j);
+    }
+
+    static Config fromJson(const json &j) {
         Config cfg;
         cfg.l1Size = j["l1Size"].get<size_t>();
         cfg.l2Size = j["l2Size"].get<size_t>();
@@ -28,6 +46,48 @@ struct Config {
         cfg.numThreads = j["numThreads"].get<int>();
         cfg.numCores = j["numCores"].get<int>();
         cfg.simulationDuration = j["simulationDuration"].get<int>();
+        cfg.nvmWpqEntries = j.value("nvmWpqEntries", static_cast<size_t>(16));
+        cfg.nvmBandwidthMBps = j.value("nvmBandwidthMBps", 16u);
+        cfg.nvmChannels = j.value("nvmChannels", static_cast<size_t>(1));
+        cfg.nvmDimmsPerChannel = j.value("nvmDimmsPerChannel", static_cast<size_t>(1));
+        cfg.nvmInterleaveBytes = j.value("nvmInterleaveBytes", static_cast<size_t>(4096));
+        cfg.persistenceDomain = j.value("persistenceDomain", std::string("ADR"));
+        cfg.flushCoalescingWindow = j.value("flushCoalescingWindow", 0u);
+        cfg.skipPredictor = j.value("skipPredictor", false);
+        cfg.hugePages = j.value("hugePages", std::string("off"));
+        cfg.prefaultMemory = j.value("prefaultMemory", false);
+        cfg.pinThreads = j.value("pinThreads", false);
+        cfg.numaPlacement = j.value("numaPlacement", std::string("spread"));
+        cfg.coreScheduler = j.value("coreScheduler", std::string("threads"));
+        cfg.schedulerWorkers = j.value("schedulerWorkers", static_cast<size_t>(0));
         return cfg;
     }
+
+    // Every field, optional ones included, so fromJson(toJson()) round-trips.
+    json toJson() const {
+        return json{
+            {"l1Size", l1Size},
+            {"l2Size", l2Size},
+            {"flushLatency", flushLatency},
+            {"cleanLatency", cleanLatency},
+            {"readLatency", readLatency},
+            {"numThreads", numThreads},
+            {"numCores", numCores},
+            {"simulationDuration", simulationDuration},
+            {"nvmWpqEntries", nvmWpqEntries},
+            {"nvmBandwidthMBps", nvmBandwidthMBps},
+            {"nvmChannels", nvmChannels},
+            {"nvmDimmsPerChannel", nvmDimmsPerChannel},
+            {"nvmInterleaveBytes", nvmInterleaveBytes},
+            {"persistenceDomain", persistenceDomain},
+            {"flushCoalescingWindow", flushCoalescingWindow},
+            {"skipPredictor", skipPredictor},
+            {"hugePages", hugePages},
+            {"prefaultMemory", prefaultMemory},
+            {"pinThreads", pinThreads},
+            {"numaPlacement", numaPlacement},
+            {"coreScheduler", coreScheduler},
+            {"schedulerWorkers", schedulerWorkers},
+        };
+    }
 };
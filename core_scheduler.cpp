@@ -0,0 +1,105 @@
+#include "core_scheduler.hpp"
+#include "sim_timing.hpp"
+#include <algorithm>
+#include <thread>
+
+CoreScheduler::CoreScheduler(size_t numWorkers, size_t quantum)
+    : numWorkers(std::max<size_t>(numWorkers, 1)), quantum(std::max<size_t>(quantum, 1)), frontier(0), remaining(0) {
+    for (size_t i = 0; i < this->numWorkers; ++i)
+        queues.push_back(std::make_unique<WorkQueue>());
+}
+
+size_t CoreScheduler::addCore(std::unique_ptr<SimulatedCore> core) {
+    cores.push_back(std::move(core));
+    simulatedTime.push_back(0);
+    return cores.size() - 1;
+}
+
+void CoreScheduler::run() {
+    for (size_t coreId = 0; coreId < cores.size(); ++coreId)
+        queues[coreId % numWorkers]->cores.push_back(coreId);
+    remaining = cores.size();
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < numWorkers; ++worker)
+        workers.emplace_back(&CoreScheduler::workerLoop, this, worker);
+    for (auto &t : workers)
+        t.join();
+}
+
+bool CoreScheduler::takeLocal(size_t worker, size_t &coreId) {
+    auto &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.queueMutex);
+    if (queue.cores.empty())
+        return false;
+    coreId = queue.cores.front();
+    queue.cores.pop_front();
+    return true;
+}
+
+// Takes from the back of the victim's queue, away from the end its owner
+// works on.
+bool CoreScheduler::steal(size_t worker, size_t &coreId) {
+    for (size_t offset = 1; offset < numWorkers; ++offset) {
+        auto &victim = *queues[(worker + offset) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.queueMutex);
+        if (victim.cores.empty())
+            continue;
+        coreId = victim.cores.back();
+        victim.cores.pop_back();
+        stats.steals++;
+        return true;
+    }
+    return false;
+}
+
+void CoreScheduler::workerLoop(size_t worker) {
+    consumeChargedLatency();
+    while (remaining.load() > 0) {
+        size_t coreId;
+        if (!takeLocal(worker, coreId) && !steal(worker, coreId)) {
+            std::this_thread::yield();
+            continue;
+        }
+        stats.quanta++;
+        bool alive = true;
+        for (size_t i = 0; i < quantum && alive; ++i) {
+            alive = cores[coreId]->step();
+            uint64_t reached = simulatedTime[coreId] += consumeChargedLatency();
+            uint64_t seen = frontier.load();
+            while (reached > seen && !frontier.compare_exchange_weak(seen, reached)) {
+            }
+            stats.steps++;
+        }
+        if (!alive) {
+            remaining--;
+            continue;
+        }
+        auto &queue = *queues[worker];
+        std::lock_guard<std::mutex> lock(queue.queueMutex);
+        queue.cores.push_back(coreId);
+    }
+}
+
+uint64_t CoreScheduler::getSimulatedTime(size_t coreId) const {
+    return simulatedTime[coreId];
+}
+
+uint64_t CoreScheduler::getSimulatedFrontier() const {
+    return frontier.load();
+}
+
+SimulatedCore& CoreScheduler::getCore(size_t coreId) {
+    return *cores[coreId];
+}
+
+size_t CoreScheduler::getNumCores() const {
+    return cores.size();
+}
+
+size_t CoreScheduler::getNumWorkers() const {
+    return numWorkers;
+}
+
+CoreSchedulerStats& CoreScheduler::getStats() {
+    return stats;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A simulated core's program, advanced one operation at a time so many cores
+// can share a host thread. Operations should run their caches under
+// TimingModel::Accumulate; the latency they charge becomes the core's
+// simulated time.
+class SimulatedCore {
+public:
+    virtual ~SimulatedCore() = default;
+    // Performs the next operation; returns false once the program is done.
+    virtual bool step() = 0;
+};
+
+struct CoreSchedulerStats {
+    std::atomic<size_t> steps;
+    std::atomic<size_t> quanta; // times a core was picked up by a worker
+    std::atomic<size_t> steals; // quanta taken from another worker's queue
+
+    CoreSchedulerStats() : steps(0), quanta(0), steals(0) {}
+};
+
+// Multiplexes simulated cores over a fixed pool of host threads. Each worker
+// owns a queue of runnable cores and runs the front one for up to `quantum`
+// operations before requeueing it; an idle worker steals from the back of
+// another worker's queue.
+class CoreScheduler {
+public:
+    CoreScheduler(size_t numWorkers, size_t quantum = 16);
+
+    // Returns the core's id.
+    size_t addCore(std::unique_ptr<SimulatedCore> core);
+    // Runs every core to completion; blocks until all are done.
+    void run();
+    // Simulated microseconds charged by the core's operations.
+    uint64_t getSimulatedTime(size_t coreId) const;
+    // Latest simulated time any core has reached. It never decreases, so it
+    // can serve as the clock of a MemoryController the cores share.
+    uint64_t getSimulatedFrontier() const;
+    SimulatedCore& getCore(size_t coreId);
+    size_t getNumCores() const;
+    size_t getNumWorkers() const;
+    CoreSchedulerStats& getStats();
+
+private:
+    struct WorkQueue {
+        std::mutex queueMutex;
+        std::deque<size_t> cores;
+    };
+
+    void workerLoop(size_t worker);
+    bool takeLocal(size_t worker, size_t &coreId);
+    bool steal(size_t worker, size_t &coreId);
+
+    size_t numWorkers;
+    size_t quantum;
+    std::vector<std::unique_ptr<SimulatedCore>> cores;
+    std::vector<uint64_t> simulatedTime;
+    std::atomic<uint64_t> frontier;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<size_t> remaining;
+    CoreSchedulerStats stats;
+};
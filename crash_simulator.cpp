@@ -0,0 +1,176 @@
+#include "crash_simulator.hpp"
+#include "persistent_data_structure.hpp"
+#include "ReadableFlexibleLogger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+
+static const size_t MAX_REPORTED_FAILURES = 10;
+
+CrashSimulator::CrashSimulator(size_t numLines, PersistenceDomain domain)
+    : numLines(numLines), domain(domain) {}
+
+void CrashSimulator::record(const Workload &workload) {
+    events.clear();
+    commits.clear();
+    CacheSimulator cache(numLines);
+    cache.setFlushLatency(0);
+    cache.setCleanLatency(0);
+    cache.setReadLatency(0);
+    cache.setPersistenceDomain(domain);
+    initialImage = cache.getPersistedImage();
+    cache.setPersistObserver([this](size_t index, int value) {
+        events.push_back({index, value});
+    });
+    workload(cache, *this);
+    cache.setPersistObserver(nullptr);
+}
+
+void CrashSimulator::commit(int token) {
+    commits.push_back({events.size(), token});
+}
+
+size_t CrashSimulator::getNumCrashPoints() const {
+    return events.size() + 1;
+}
+
+int CrashSimulator::lastCommittedAt(size_t eventIndex) const {
+    auto it = std::upper_bound(commits.begin(), commits.end(), eventIndex,
+                               [](size_t count, const Commit &c) { return count < c.eventCount; });
+    return it == commits.begin() ? -1 : std::prev(it)->token;
+}
+
+CrashReport CrashSimulator::checkExhaustive(const RecoveryCheck &check, unsigned numThreads) {
+    std::vector<size_t> points(getNumCrashPoints());
+    for (size_t i = 0; i < points.size(); ++i)
+        points[i] = i;
+    return checkPoints(points, check, numThreads);
+}
+
+CrashReport CrashSimulator::checkRandom(size_t samples, unsigned seed, const RecoveryCheck &check, unsigned numThreads) {
+    std::mt19937_64 generator(seed);
+    std::uniform_int_distribution<size_t> distribution(0, getNumCrashPoints() - 1);
+    std::vector<size_t> points(samples);
+    for (auto &point : points)
+        point = distribution(generator);
+    std::sort(points.begin(), points.end());
+    return checkPoints(points, check, numThreads);
+}
+
+// Points must be sorted: each thread takes a contiguous slice and rolls its
+// image forward through the event log instead of rebuilding it per point.
+CrashReport CrashSimulator::checkPoints(const std::vector<size_t> &points, const RecoveryCheck &check, unsigned numThreads) {
+    numThreads = std::max(1u, std::min<unsigned>(numThreads, static_cast<unsigned>(std::max<size_t>(points.size(), 1))));
+    std::atomic<size_t> violations(0);
+    std::mutex failureMutex;
+    CrashReport report;
+    report.crashPointsChecked = points.size();
+
+    auto worker = [&](size_t begin, size_t end) {
+        Image image = initialImage;
+        size_t applied = 0;
+        for (size_t p = begin; p < end; ++p) {
+            for (; applied < points[p]; ++applied)
+                image[events[applied].index] = events[applied].value;
+            CrashPoint point{points[p], lastCommittedAt(points[p])};
+            std::string error = check(image, point);
+            if (error.empty())
+                continue;
+            violations++;
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (report.failures.size() < MAX_REPORTED_FAILURES)
+                report.failures.push_back("crash after " + std::to_string(point.eventIndex) + " events: " + error);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t chunk = (points.size() + numThreads - 1) / numThreads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        size_t begin = std::min(points.size(), t * chunk);
+        size_t end = std::min(points.size(), begin + chunk);
+        threads.emplace_back(worker, begin, end);
+    }
+    for (auto &t : threads)
+        t.join();
+
+    report.violations = violations;
+    return report;
+}
+
+CrashSimulator::Workload persistentCounterWorkload(size_t lineIndex, int iterations, bool useSkipOptimization) {
+    return [=](CacheSimulator &cache, CrashSimulator &crashSim) {
+        PersistentCounter counter(cache, lineIndex);
+        for (int i = 0; i < iterations; ++i) {
+            counter.increment();
+            counter.persist(useSkipOptimization);
+            crashSim.commit(counter.get());
+        }
+    };
+}
+
+CrashSimulator::RecoveryCheck persistentCounterCheck(size_t lineIndex, int iterations) {
+    return [=](const CrashSimulator::Image &image, const CrashPoint &point) -> std::string {
+        int recovered = image[lineIndex];
+        if (recovered < point.lastCommitted)
+            return "counter recovered as " + std::to_string(recovered) + " but " +
+                   std::to_string(point.lastCommitted) + " was persisted";
+        if (recovered < 0 || recovered > iterations)
+            return "counter recovered as out-of-range value " + std::to_string(recovered);
+        return "";
+    };
+}
+
+// Distinct, non-zero payload word for one part of a log entry, derived the
+// same way the logger derives its metadata.
+static int logPayloadValue(size_t entry, size_t part) {
+    char oldData[FIXED_PAYLOAD_SIZE];
+    char newData[FIXED_PAYLOAD_SIZE];
+    std::memset(oldData, 0xA5, FIXED_PAYLOAD_SIZE);
+    std::memset(newData, 0, FIXED_PAYLOAD_SIZE);
+    std::string text = "entry " + std::to_string(entry) + " part " + std::to_string(part);
+    std::strncpy(newData, text.c_str(), FIXED_PAYLOAD_SIZE - 1);
+    return static_cast<int>(((entry + 1) << 16) | computeFlexibleMeta(oldData, newData));
+}
+
+CrashSimulator::Workload validityLogWorkload(size_t numEntries, bool useSkipOptimization) {
+    return [=](CacheSimulator &cache, CrashSimulator &crashSim) {
+        for (size_t entry = 0; entry < numEntries; ++entry) {
+            size_t base = entry * LOG_ENTRY_LINES;
+            for (size_t part = 0; part < LOG_PAYLOAD_LINES; ++part)
+                cache.writeLine(base + part, logPayloadValue(entry, part));
+            cache.writeLine(base + LOG_PAYLOAD_LINES, 0);
+            for (size_t part = 0; part <= LOG_PAYLOAD_LINES; ++part)
+                cache.flushLine(base + part, useSkipOptimization);
+            cache.memoryFence();
+            cache.writeLine(base + LOG_PAYLOAD_LINES, LOG_VALIDITY_MARKER);
+            cache.flushLine(base + LOG_PAYLOAD_LINES, useSkipOptimization);
+            cache.memoryFence();
+            crashSim.commit(static_cast<int>(entry));
+        }
+    };
+}
+
+CrashSimulator::RecoveryCheck validityLogCheck(size_t numEntries) {
+    return [=](const CrashSimulator::Image &image, const CrashPoint &point) -> std::string {
+        for (size_t entry = 0; entry < numEntries; ++entry) {
+            size_t base = entry * LOG_ENTRY_LINES;
+            int validity = image[base + LOG_PAYLOAD_LINES];
+            if (validity != 0 && validity != LOG_VALIDITY_MARKER)
+                return "entry " + std::to_string(entry) + " has a corrupt validity field";
+            bool acknowledged = static_cast<int>(entry) <= point.lastCommitted;
+            if (validity != LOG_VALIDITY_MARKER) {
+                if (acknowledged)
+                    return "acknowledged entry " + std::to_string(entry) + " is not valid";
+                continue;
+            }
+            for (size_t part = 0; part < LOG_PAYLOAD_LINES; ++part) {
+                if (image[base + part] != logPayloadValue(entry, part))
+                    return "entry " + std::to_string(entry) + " is valid but payload part " +
+                           std::to_string(part) + " is torn";
+            }
+        }
+        return "";
+    };
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "cache_simulator.hpp"
+#include <vector>
+#include <string>
+#include <functional>
+
+// A crash point is identified by how many persist events had reached the
+// persistence domain when power was lost.
+struct CrashPoint {
+    size_t eventIndex;
+    int lastCommitted; // last token the workload acknowledged as durable, -1 if none
+};
+
+struct CrashReport {
+    size_t crashPointsChecked;
+    size_t violations;
+    std::vector<std::string> failures; // first few violation messages
+};
+
+// Records the order in which a workload's stores reach the persistence domain,
+// then replays the persisted image at chosen crash points and runs a recovery
+// check on each one. Crash points are checked in parallel across threads.
+class CrashSimulator {
+public:
+    using Image = std::vector<int>;
+    using Workload = std::function<void(CacheSimulator &cache, CrashSimulator &crashSim)>;
+    // Returns an empty string if the recovered image is consistent, otherwise a description of the violation.
+    using RecoveryCheck = std::function<std::string(const Image &image, const CrashPoint &point)>;
+
+    CrashSimulator(size_t numLines, PersistenceDomain domain);
+
+    // Runs the workload on a zero-latency cache and records its persist events.
+    void record(const Workload &workload);
+    // Called by the workload once an operation is guaranteed durable; recovery
+    // from any later crash must observe it.
+    void commit(int token);
+    size_t getNumCrashPoints() const;
+
+    CrashReport checkExhaustive(const RecoveryCheck &check, unsigned numThreads);
+    CrashReport checkRandom(size_t samples, unsigned seed, const RecoveryCheck &check, unsigned numThreads);
+
+private:
+    struct PersistEvent {
+        size_t index;
+        int value;
+    };
+    struct Commit {
+        size_t eventCount;
+        int token;
+    };
+
+    CrashReport checkPoints(const std::vector<size_t> &points, const RecoveryCheck &check, unsigned numThreads);
+    int lastCommittedAt(size_t eventIndex) const;
+
+    size_t numLines;
+    PersistenceDomain domain;
+    Image initialImage;
+    std::vector<PersistEvent> events;
+    std::vector<Commit> commits;
+};
+
+// PersistentCounter at lineIndex, incremented and persisted `iterations` times.
+// Recovery must find a value no older than the last acknowledged persist.
+CrashSimulator::Workload persistentCounterWorkload(size_t lineIndex, int iterations, bool useSkipOptimization);
+CrashSimulator::RecoveryCheck persistentCounterCheck(size_t lineIndex, int iterations);
+
+// ReadableFlexibleLogger's validity-field protocol laid out in cache lines: each
+// entry has LOG_PAYLOAD_LINES payload lines followed by a validity line that is
+// set to LOG_VALIDITY_MARKER only after the payload has been flushed and fenced.
+// Recovery must never see a valid entry with a torn payload, and every
+// acknowledged entry must be valid.
+constexpr size_t LOG_PAYLOAD_LINES = 2;
+constexpr size_t LOG_ENTRY_LINES = LOG_PAYLOAD_LINES + 1;
+CrashSimulator::Workload validityLogWorkload(size_t numEntries, bool useSkipOptimization);
+CrashSimulator::RecoveryCheck validityLogCheck(size_t numEntries);
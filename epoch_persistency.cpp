@@ -0,0 +1,123 @@
+#include "epoch_persistency.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+EpochPersister::EpochPersister(CacheSimulator &cache, size_t maxPendingEpochs)
+    : cache(cache), maxPendingEpochs(std::max<size_t>(maxPendingEpochs, 1)),
+      currentEpoch(0), lastClosedEpoch(0), persistedEpoch(0), inEpoch(false), stopping(false), flushScheduler(nullptr),
+      drainer(&EpochPersister::drainLoop, this) {}
+
+EpochPersister::~EpochPersister() {
+    sync();
+    {
+        std::lock_guard<std::mutex> lock(epochMutex);
+        stopping = true;
+    }
+    epochCv.notify_all();
+    drainer.join();
+}
+
+uint64_t EpochPersister::beginEpoch() {
+    std::lock_guard<std::mutex> lock(epochMutex);
+    if (inEpoch)
+        throw std::logic_error("beginEpoch called while an epoch is already open");
+    inEpoch = true;
+    currentLines.clear();
+    return ++currentEpoch;
+}
+
+void EpochPersister::write(size_t index, int value) {
+    std::unique_lock<std::mutex> lock(epochMutex);
+    if (!inEpoch)
+        throw std::logic_error("write called outside of an epoch");
+    auto owner = lineOwner.find(index);
+    if (owner != lineOwner.end() && owner->second != currentEpoch) {
+        // Overwriting the line now could persist this epoch's value before the
+        // older epoch is complete, so wait for it.
+        uint64_t olderEpoch = owner->second;
+        stats.epochConflicts++;
+        epochCv.wait(lock, [&] { return persistedEpoch >= olderEpoch; });
+    }
+    if (lineOwner[index] != currentEpoch) {
+        lineOwner[index] = currentEpoch;
+        currentLines.push_back(index);
+    }
+    cache.writeLine(index, value);
+}
+
+uint64_t EpochPersister::endEpoch() {
+    std::unique_lock<std::mutex> lock(epochMutex);
+    if (!inEpoch)
+        throw std::logic_error("endEpoch called without an open epoch");
+    if (closedEpochs.size() >= maxPendingEpochs) {
+        stats.writerStalls++;
+        epochCv.wait(lock, [&] { return closedEpochs.size() < maxPendingEpochs; });
+    }
+    inEpoch = false;
+    lastClosedEpoch = currentEpoch;
+    closedEpochs.push_back({currentEpoch, std::move(currentLines)});
+    currentLines.clear();
+    epochCv.notify_all();
+    return currentEpoch;
+}
+
+void EpochPersister::waitForEpoch(uint64_t epoch) {
+    std::unique_lock<std::mutex> lock(epochMutex);
+    epochCv.wait(lock, [&] { return persistedEpoch >= epoch; });
+}
+
+void EpochPersister::sync() {
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(epochMutex);
+        target = lastClosedEpoch;
+    }
+    waitForEpoch(target);
+}
+
+uint64_t EpochPersister::getPersistedEpoch() {
+    std::lock_guard<std::mutex> lock(epochMutex);
+    return persistedEpoch;
+}
+
+EpochStats& EpochPersister::getStats() {
+    return stats;
+}
+
+void EpochPersister::setFlushScheduler(FlushScheduler *scheduler) {
+    std::lock_guard<std::mutex> lock(epochMutex);
+    flushScheduler = scheduler;
+}
+
+void EpochPersister::drainLoop() {
+    std::unique_lock<std::mutex> lock(epochMutex);
+    while (true) {
+        epochCv.wait(lock, [&] { return stopping || !closedEpochs.empty(); });
+        if (closedEpochs.empty())
+            return;
+        // The epoch stays queued until it is persisted, so it still counts
+        // against maxPendingEpochs. endEpoch only appends, which leaves this
+        // reference valid while the lock is released.
+        const Epoch &epoch = closedEpochs.front();
+        FlushScheduler *scheduler = flushScheduler;
+        lock.unlock();
+
+        // Within an epoch the order does not matter; only the closing fence does.
+        std::vector<size_t> order = scheduler ? scheduler->schedule(epoch.lines) : epoch.lines;
+        for (size_t index : order)
+            cache.flushLine(index, true);
+        cache.memoryFence();
+        stats.linesFlushed += epoch.lines.size();
+        stats.epochsPersisted++;
+
+        lock.lock();
+        persistedEpoch = epoch.id;
+        for (size_t index : epoch.lines) {
+            auto owner = lineOwner.find(index);
+            if (owner != lineOwner.end() && owner->second == epoch.id)
+                lineOwner.erase(owner);
+        }
+        closedEpochs.pop_front();
+        epochCv.notify_all();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "cache_simulator.hpp"
+#include "flush_scheduler.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct EpochStats {
+    std::atomic<size_t> epochsPersisted;
+    std::atomic<size_t> linesFlushed;
+    std::atomic<size_t> epochConflicts; // writes that had to wait for an older epoch touching the same line
+    std::atomic<size_t> writerStalls;   // endEpoch calls blocked by the staleness bound
+
+    EpochStats() : epochsPersisted(0), linesFlushed(0), epochConflicts(0), writerStalls(0) {}
+};
+
+// Buffered epoch persistency on top of a CacheSimulator. Writes inside an epoch
+// may persist lazily and in any order; only epoch boundaries are ordered. A
+// background drainer flushes each closed epoch's lines and fences before it
+// starts on the next one, so the writer never waits on flush latency unless
+// more than maxPendingEpochs epochs are outstanding or it rewrites a line that
+// an older, not yet persisted epoch still owns.
+class EpochPersister {
+public:
+    EpochPersister(CacheSimulator &cache, size_t maxPendingEpochs);
+    ~EpochPersister();
+
+    // Returns the id of the epoch that was opened.
+    uint64_t beginEpoch();
+    void write(size_t index, int value);
+    // Closes the current epoch and hands it to the drainer; returns its id.
+    uint64_t endEpoch();
+    // Blocks until the given epoch (and therefore every earlier one) is durable.
+    void waitForEpoch(uint64_t epoch);
+    void sync();
+    uint64_t getPersistedEpoch();
+    EpochStats& getStats();
+    // Orders the flushes within each epoch. Pass nullptr for write order.
+    void setFlushScheduler(FlushScheduler *scheduler);
+
+private:
+    struct Epoch {
+        uint64_t id;
+        std::vector<size_t> lines;
+    };
+
+    void drainLoop();
+
+    CacheSimulator &cache;
+    size_t maxPendingEpochs;
+    std::mutex epochMutex;
+    std::condition_variable epochCv;
+    std::deque<Epoch> closedEpochs;
+    std::vector<size_t> currentLines;
+    std::unordered_map<size_t, uint64_t> lineOwner; // line -> newest epoch that wrote it and is not yet durable
+    uint64_t currentEpoch;
+    uint64_t lastClosedEpoch;
+    uint64_t persistedEpoch;
+    bool inEpoch;
+    bool stopping;
+    FlushScheduler *flushScheduler;
+    EpochStats stats;
+    std::thread drainer;
+};
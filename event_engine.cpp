@@ -0,0 +1,109 @@
+#include "event_engine.hpp"
+#include "sim_timing.hpp"
+#include <algorithm>
+
+CoreProgram::CoreProgram(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+CoreProgram::CoreProgram(CoreProgram &&other) noexcept : handle(other.handle) {
+    other.handle = nullptr;
+}
+
+CoreProgram::~CoreProgram() {
+    if (handle)
+        handle.destroy();
+}
+
+EventEngine::EventEngine() : currentTime(0), nextSequence(0), eventsProcessed(0), peakPendingEvents(0) {}
+
+EventEngine::~EventEngine() {
+    for (auto handle : programs)
+        handle.destroy();
+}
+
+void EventEngine::spawn(CoreProgram program) {
+    programs.push_back(program.handle);
+    schedule(program.handle, 0);
+    program.handle = nullptr;
+}
+
+void EventEngine::schedule(std::coroutine_handle<> handle, uint64_t delay) {
+    scheduleAt(handle, currentTime + delay);
+}
+
+void EventEngine::scheduleAt(std::coroutine_handle<> handle, uint64_t time) {
+    events.push({std::max(time, currentTime), nextSequence++, handle});
+    peakPendingEvents = std::max(peakPendingEvents, events.size());
+}
+
+void EventEngine::run() {
+    runUntil(NO_EVENT);
+    rethrowProgramFailures();
+}
+
+void EventEngine::runUntil(uint64_t endTime) {
+    consumeChargedLatency();
+    while (!events.empty() && events.top().time < endTime) {
+        Event event = events.top();
+        events.pop();
+        currentTime = event.time;
+        eventsProcessed++;
+        event.handle.resume();
+    }
+}
+
+uint64_t EventEngine::nextEventTime() const {
+    return events.empty() ? NO_EVENT : events.top().time;
+}
+
+void EventEngine::rethrowProgramFailures() {
+    for (auto handle : programs) {
+        if (handle.promise().exception)
+            std::rethrow_exception(handle.promise().exception);
+    }
+}
+
+uint64_t EventEngine::now() const {
+    return currentTime;
+}
+
+size_t EventEngine::getEventsProcessed() const {
+    return eventsProcessed;
+}
+
+size_t EventEngine::getPeakPendingEvents() const {
+    return peakPendingEvents;
+}
+
+AsyncCache::AsyncCache(EventEngine &engine, CacheSimulator &cache)
+    : engine(engine), cache(cache), flushesDoneAt(0), flushesInFlight(0) {}
+
+void AsyncCache::writeLine(size_t index, int value) {
+    cache.writeLine(index, value);
+}
+
+void AsyncCache::ReadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    value = owner.cache.readLine(index);
+    owner.engine.schedule(handle, consumeChargedLatency());
+}
+
+bool AsyncCache::FlushAwaiter::await_resume() {
+    bool issued = owner.cache.flushLine(index, true);
+    uint64_t latency = consumeChargedLatency();
+    if (issued) {
+        owner.flushesDoneAt = std::max(owner.flushesDoneAt, owner.engine.now() + latency);
+        owner.flushesInFlight++;
+    }
+    return issued;
+}
+
+void AsyncCache::FenceAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    owner.cache.memoryFence();
+    consumeChargedLatency();
+    uint64_t now = owner.engine.now();
+    owner.engine.schedule(handle, owner.flushesDoneAt > now ? owner.flushesDoneAt - now : 0);
+    owner.flushesInFlight = 0;
+}
+
+size_t AsyncCache::getFlushesInFlight() const {
+    return flushesInFlight;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include "cache_simulator.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <queue>
+#include <vector>
+
+// Return type of a coroutine core program. The program starts suspended and
+// runs once handed to EventEngine::spawn, which then owns it.
+class CoreProgram {
+public:
+    struct promise_type {
+        std::exception_ptr exception;
+
+        CoreProgram get_return_object() {
+            return CoreProgram(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    CoreProgram(CoreProgram &&other) noexcept;
+    CoreProgram& operator=(CoreProgram &&other) = delete;
+    ~CoreProgram();
+
+private:
+    friend class EventEngine;
+    explicit CoreProgram(std::coroutine_handle<promise_type> handle);
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Single-threaded discrete-event engine with a virtual clock in simulated
+// microseconds. Suspended coroutines wait in a time-ordered queue; equal
+// times resume in scheduling order, so runs are deterministic.
+class EventEngine {
+public:
+    static constexpr uint64_t NO_EVENT = static_cast<uint64_t>(-1);
+
+    EventEngine();
+    ~EventEngine();
+    EventEngine(const EventEngine &) = delete;
+    EventEngine& operator=(const EventEngine &) = delete;
+
+    // Takes ownership of the program and starts it at the current time.
+    void spawn(CoreProgram program);
+    // Resumes `handle` after `delay` simulated microseconds.
+    void schedule(std::coroutine_handle<> handle, uint64_t delay);
+    // Resumes `handle` at absolute simulated time `time` (not before now()).
+    void scheduleAt(std::coroutine_handle<> handle, uint64_t time);
+    // Processes events until none remain. Rethrows the first exception a
+    // program let escape.
+    void run();
+    // Processes events strictly earlier than `endTime` and leaves later ones
+    // queued; the clock stops at the last processed event.
+    void runUntil(uint64_t endTime);
+    // Time of the earliest queued event, or NO_EVENT if the queue is empty.
+    uint64_t nextEventTime() const;
+    void rethrowProgramFailures();
+    uint64_t now() const;
+    size_t getEventsProcessed() const;
+    size_t getPeakPendingEvents() const;
+
+    struct DelayAwaiter {
+        EventEngine &engine;
+        uint64_t delay;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { engine.schedule(handle, delay); }
+        void await_resume() const noexcept {}
+    };
+    // co_await engine.delay(us) suspends the program for `us` simulated microseconds.
+    DelayAwaiter delay(uint64_t microseconds) { return DelayAwaiter{*this, microseconds}; }
+
+private:
+    struct Event {
+        uint64_t time;
+        uint64_t sequence;
+        std::coroutine_handle<> handle;
+    };
+    struct Later {
+        bool operator()(const Event &a, const Event &b) const {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, Later> events;
+    std::vector<std::coroutine_handle<CoreProgram::promise_type>> programs;
+    uint64_t currentTime;
+    uint64_t nextSequence;
+    size_t eventsProcessed;
+    size_t peakPendingEvents;
+};
+
+// Awaitable front end to a CacheSimulator for coroutine core programs; use
+// one per program. The cache must run under TimingModel::Accumulate so each
+// operation's latency becomes simulated time instead of a host sleep.
+// Flushes are posted: the program continues at once, and its next
+// memoryFence waits until every flush it issued has completed, as
+// clwb/sfence would.
+class AsyncCache {
+public:
+    AsyncCache(EventEngine &engine, CacheSimulator &cache);
+
+    void writeLine(size_t index, int value);
+
+    struct ReadAwaiter {
+        AsyncCache &owner;
+        size_t index;
+        int value;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        int await_resume() const noexcept { return value; }
+    };
+    struct FlushAwaiter {
+        AsyncCache &owner;
+        size_t index;
+        bool await_ready() const noexcept { return true; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        bool await_resume();
+    };
+    struct FenceAwaiter {
+        AsyncCache &owner;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+    };
+
+    ReadAwaiter readLine(size_t index) { return ReadAwaiter{*this, index, 0}; }
+    // Applies the skip optimization, like CacheSimulator::flushLine(index, true).
+    FlushAwaiter flushLine(size_t index) { return FlushAwaiter{*this, index}; }
+    FenceAwaiter memoryFence() { return FenceAwaiter{*this}; }
+    // Flushes issued since the last fence.
+    size_t getFlushesInFlight() const;
+
+private:
+    EventEngine &engine;
+    CacheSimulator &cache;
+    uint64_t flushesDoneAt; // simulated time the last posted flush completes
+    size_t flushesInFlight;
+};
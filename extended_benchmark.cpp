@@ -1,15 +1,19 @@
 #include "cache_simulator.hpp"
 #include "persistent_data_structure.hpp"
 #include "multi_level_cache.hpp"
+#include "memory_controller.hpp"
+#include "epoch_persistency.hpp"
+#include "flush_scheduler.hpp"
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <atomic>
 #include <random>
+#include <algorithm>
 
 void benchmarkMultiLevel(CacheSimulator &l1Cache, L2Cache &l2Cache, bool useSkipOptimization, int numThreads) {
-    const size_t numLines = l1Cache.getCache().size();
+    const size_t numLines = l1Cache.getNumLines();
     std::atomic<size_t> currentIndex(0);
     auto worker = [&]() {
         while (true) {
@@ -17,7 +21,7 @@ void benchmarkMultiLevel(CacheSimulator &l1Cache, L2Cache &l2Cache, bool useSkip
             if (idx >= numLines) break;
             bool flushed = l1Cache.flushLine(idx, useSkipOptimization);
             if (flushed) {
-                int data = l1Cache.getCache()[idx].data;
+                int data = l1Cache.peekLine(idx);
                 l2Cache.updateLineFromL1(idx, data, false);
             }
         }
@@ -32,7 +36,7 @@ void benchmarkMultiLevel(CacheSimulator &l1Cache, L2Cache &l2Cache, bool useSkip
 
 void simulateEvictions(CacheSimulator &l1Cache, L2Cache &l2Cache, int durationMillis) {
     std::default_random_engine generator(static_cast<unsigned>(std::chrono::steady_clock::now().time_since_epoch().count()));
-    std::uniform_int_distribution<size_t> distribution(0, l1Cache.getCache().size() - 1);
+    std::uniform_int_distribution<size_t> distribution(0, l1Cache.getNumLines() - 1);
     auto start = std::chrono::steady_clock::now();
     while (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() < durationMillis) {
         size_t idx = distribution(generator);
@@ -48,7 +52,7 @@ void benchmarkPersistentMultiLevel(CacheSimulator &l1Cache, L2Cache &l2Cache, bo
     for (int i = 0; i < iterations; ++i) {
         counter.increment();
         l1Cache.flushLine(0, useSkipOptimization);
-        int data = l1Cache.getCache()[0].data;
+        int data = l1Cache.peekLine(0);
         l2Cache.updateLineFromL1(0, data, false);
         l1Cache.memoryFence();
     }
@@ -58,18 +62,173 @@ void benchmarkPersistentMultiLevel(CacheSimulator &l1Cache, L2Cache &l2Cache, bo
               << duration << " ms, final counter: " << counter.get() << std::endl;
 }
 
+void benchmarkNvmWritePath(CacheSimulator &l1Cache, L2Cache &l2Cache, int numThreads) {
+    MemoryController nvm(8, 1);
+    l1Cache.setMemoryController(&nvm);
+    l1Cache.resetCache();
+    for (size_t i = 0; i < l1Cache.getNumLines(); ++i) {
+        l1Cache.setLineState(i, true, false);
+    }
+    auto start = std::chrono::steady_clock::now();
+    benchmarkMultiLevel(l1Cache, l2Cache, false, numThreads);
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    l1Cache.setMemoryController(nullptr);
+
+    auto &stats = nvm.getStats();
+    std::cout << "Bandwidth-bound flush of " << l1Cache.getNumLines() << " lines: " << duration << " ms" << std::endl;
+    std::cout << "Combined in WPQ: " << stats.combinedWrites << ", media writes: " << stats.mediaWrites
+              << ", WPQ full stalls: " << stats.wpqFullStalls << " (" << stats.stallMicros << " us)" << std::endl;
+}
+
+// Flushes 256 lines either packed into one channel's interleave chunks or spread
+// round-robin across all channels, to compare data placement.
+void benchmarkChannelPlacement(CacheSimulator &l1Cache, int numThreads, bool spread) {
+    const size_t numChannels = 4;
+    const size_t interleaveBytes = 4096;
+    const size_t linesPerChunk = interleaveBytes / CACHE_LINE_SIZE;
+    MemoryController nvm(8, 1, numChannels, 1, interleaveBytes);
+    l1Cache.setMemoryController(&nvm);
+    l1Cache.resetCache();
+
+    std::vector<size_t> lines;
+    for (size_t i = 0; lines.size() < 256 && i < l1Cache.getNumLines(); ++i) {
+        size_t channel = (i / linesPerChunk) % numChannels;
+        if (spread || channel == 0)
+            lines.push_back(i);
+    }
+    for (size_t idx : lines)
+        l1Cache.writeLine(idx, static_cast<int>(idx));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        while (true) {
+            size_t n = next.fetch_add(1);
+            if (n >= lines.size()) break;
+            l1Cache.flushLine(lines[n], false);
+        }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i)
+        threads.emplace_back(worker);
+    for (auto &t : threads)
+        t.join();
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    l1Cache.setMemoryController(nullptr);
+
+    std::cout << (spread ? "Spread across channels: " : "Single channel: ") << duration << " ms, stalls per channel:";
+    for (size_t ch = 0; ch < nvm.getNumChannels(); ++ch)
+        std::cout << " " << nvm.getChannelStats(ch).wpqFullStalls;
+    std::cout << std::endl;
+}
+
+// Log-append path: each entry writes two payload lines and then a validity
+// line that may only persist after the payload. Strict persistency flushes and
+// fences inline; buffered epoch persistency puts payload and validity in
+// consecutive epochs and lets the drainer persist them in the background, with
+// at most maxPendingEpochs epochs of staleness (0 selects strict persistency).
+void benchmarkEpochLogging(CacheSimulator &l1Cache, int entries, size_t maxPendingEpochs) {
+    bool buffered = maxPendingEpochs > 0;
+    l1Cache.resetCache();
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point writerDone;
+    if (!buffered) {
+        for (int e = 0; e < entries; ++e) {
+            size_t base = static_cast<size_t>(e) * 3;
+            l1Cache.writeLine(base, e);
+            l1Cache.writeLine(base + 1, e);
+            l1Cache.flushLine(base, true);
+            l1Cache.flushLine(base + 1, true);
+            l1Cache.memoryFence();
+            l1Cache.writeLine(base + 2, 0xBEEF);
+            l1Cache.flushLine(base + 2, true);
+            l1Cache.memoryFence();
+        }
+        writerDone = std::chrono::steady_clock::now();
+    } else {
+        EpochPersister epochs(l1Cache, maxPendingEpochs);
+        for (int e = 0; e < entries; ++e) {
+            size_t base = static_cast<size_t>(e) * 3;
+            epochs.beginEpoch();
+            epochs.write(base, e);
+            epochs.write(base + 1, e);
+            epochs.endEpoch();
+            epochs.beginEpoch();
+            epochs.write(base + 2, 0xBEEF);
+            epochs.endEpoch();
+        }
+        writerDone = std::chrono::steady_clock::now();
+        epochs.sync();
+        auto &stats = epochs.getStats();
+        std::cout << "Epochs persisted: " << stats.epochsPersisted << ", writer stalls: " << stats.writerStalls
+                  << ", epoch conflicts: " << stats.epochConflicts << std::endl;
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto writerMs = std::chrono::duration_cast<std::chrono::milliseconds>(writerDone - start).count();
+    auto durableMs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    if (buffered)
+        std::cout << "Buffered epoch persistency (staleness bound " << maxPendingEpochs << ")";
+    else
+        std::cout << "Strict persistency";
+    std::cout << ", " << entries << " log entries: writer "
+              << writerMs << " ms, durable after " << durableMs << " ms" << std::endl;
+}
+
+// Flushes 512 scattered lines in random order, fencing every 128 flushes. All
+// flushes between two fences are deferred and issued through the scheduler,
+// so only the order they reach the memory controller differs between runs.
+void benchmarkFlushScheduling(CacheSimulator &l1Cache, FlushSchedulePolicy policy) {
+    MemoryController nvm(8, 1, 2, 1, 4096);
+    // The lines span 32KB per DIMM, so small rows leave several rows per bank.
+    FlushScheduler scheduler(policy, nvm, 4, 1024);
+    l1Cache.resetCache();
+    l1Cache.setMemoryController(&nvm);
+    l1Cache.setFlushScheduler(&scheduler);
+    l1Cache.setFlushCoalescingWindow(1000000);
+
+    std::vector<size_t> lines(l1Cache.getNumLines());
+    for (size_t i = 0; i < lines.size(); ++i)
+        lines[i] = i;
+    std::mt19937 generator(7);
+    std::shuffle(lines.begin(), lines.end(), generator);
+    lines.resize(512);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < lines.size(); ++n) {
+        l1Cache.writeLine(lines[n], static_cast<int>(n));
+        l1Cache.flushLine(lines[n], true);
+        if ((n + 1) % 128 == 0)
+            l1Cache.memoryFence();
+    }
+    l1Cache.memoryFence();
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    l1Cache.setFlushCoalescingWindow(0);
+    l1Cache.setFlushScheduler(nullptr);
+    l1Cache.setMemoryController(nullptr);
+    auto &stats = scheduler.getStats();
+    auto &nvmStats = nvm.getStats();
+    std::cout << flushSchedulePolicyName(policy) << ": " << duration << " ms, row hits " << stats.rowHits
+              << "/" << stats.requests << ", block neighbours " << stats.blockNeighbours
+              << ", combined in WPQ " << nvmStats.combinedWrites << ", media writes " << nvmStats.mediaWrites
+              << ", WPQ stalls " << nvmStats.wpqFullStalls << std::endl;
+}
+
 int main() {
     const size_t l1Size = 1024;
     const size_t l2Size = l1Size;
     CacheSimulator l1Cache(l1Size);
     L2Cache l2Cache(l2Size);
     const int numThreads = 4;
+    l1Cache.setPersistencyTracking(true);
 
     std::cout << "=== Benchmark: Multi-Level Flush ===" << std::endl;
     l1Cache.resetCache();
     for (size_t i = 0; i < l1Size; ++i) {
-        l1Cache.getCache()[i].dirty = true;
-        l1Cache.getCache()[i].skip = false;
+        l1Cache.setLineState(i, true, false);
     }
     auto startTime = std::chrono::steady_clock::now();
     benchmarkMultiLevel(l1Cache, l2Cache, false, numThreads);
@@ -79,8 +238,7 @@ int main() {
 
     l1Cache.resetCache();
     for (size_t i = 0; i < l1Size; ++i) {
-        l1Cache.getCache()[i].dirty = false;
-        l1Cache.getCache()[i].skip = true;
+        l1Cache.setLineState(i, false, true);
     }
     startTime = std::chrono::steady_clock::now();
     benchmarkMultiLevel(l1Cache, l2Cache, true, numThreads);
@@ -94,6 +252,23 @@ int main() {
     l1Cache.resetCache();
     benchmarkPersistentMultiLevel(l1Cache, l2Cache, true, 1000);
 
+    std::cout << "\n=== Benchmark: NVM Write Path ===" << std::endl;
+    benchmarkNvmWritePath(l1Cache, l2Cache, numThreads);
+
+    std::cout << "\n=== Benchmark: NVM Channel Placement ===" << std::endl;
+    benchmarkChannelPlacement(l1Cache, numThreads, false);
+    benchmarkChannelPlacement(l1Cache, numThreads, true);
+
+    std::cout << "\n=== Benchmark: Epoch Persistency Logging ===" << std::endl;
+    benchmarkEpochLogging(l1Cache, 200, 0);
+    benchmarkEpochLogging(l1Cache, 200, 8);
+    benchmarkEpochLogging(l1Cache, 200, 1024);
+
+    std::cout << "\n=== Benchmark: Flush Scheduling ===" << std::endl;
+    for (FlushSchedulePolicy policy : {FlushSchedulePolicy::FCFS, FlushSchedulePolicy::AddressSorted,
+                                       FlushSchedulePolicy::BankRoundRobin, FlushSchedulePolicy::FRFCFS})
+        benchmarkFlushScheduling(l1Cache, policy);
+
     std::cout << "\n=== Simulation: Random L1 Evictions ===" << std::endl;
     std::thread evictionThread(simulateEvictions, std::ref(l1Cache), std::ref(l2Cache), 200);
     evictionThread.join();
@@ -107,5 +282,14 @@ int main() {
     std::cout << "Read hits: " << stats.readHits << std::endl;
     std::cout << "Read misses: " << stats.readMisses << std::endl;
 
+    std::cout << "\n=== Persistency Ordering Report ===" << std::endl;
+    PersistencyReport report = l1Cache.getPersistencyReport();
+    std::cout << "Unpersisted stores: " << report.unpersistedStores << std::endl;
+    std::cout << "Unfenced flushes: " << report.unfencedFlushes << std::endl;
+    std::cout << "Redundant flushes issued: " << report.redundantFlushes << std::endl;
+    std::cout << "Ordering violations: " << report.orderingViolations << std::endl;
+    for (const auto &sample : report.samples)
+        std::cout << "  " << sample << std::endl;
+
     return 0;
 }
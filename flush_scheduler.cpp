@@ -0,0 +1,152 @@
+#include "flush_scheduler.hpp"
+#include "cache_simulator.hpp"
+#include "memory_controller.hpp"
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <unordered_map>
+
+static const size_t NO_OPEN_ROW = static_cast<size_t>(-1);
+
+std::string flushSchedulePolicyName(FlushSchedulePolicy policy) {
+    switch (policy) {
+    case FlushSchedulePolicy::FCFS: return "FCFS";
+    case FlushSchedulePolicy::AddressSorted: return "address-sorted";
+    case FlushSchedulePolicy::BankRoundRobin: return "bank-round-robin";
+    case FlushSchedulePolicy::FRFCFS: return "FR-FCFS";
+    }
+    return "unknown";
+}
+
+FlushScheduler::FlushScheduler(FlushSchedulePolicy policy, const MemoryController &controller,
+                               size_t banksPerDimm, size_t rowBytes)
+    : policy(policy), controller(controller), banksPerDimm(std::max<size_t>(banksPerDimm, 1)),
+      numBanks(controller.getNumChannels() * controller.getDimmsPerChannel() * this->banksPerDimm),
+      rowBytes(std::max(rowBytes, CACHE_LINE_SIZE)) {}
+
+// Banks are numbered DIMM by DIMM, in the controller's channel-major order.
+size_t FlushScheduler::bankOf(size_t line) const {
+    NvmLocation location = controller.mapAddress(line * CACHE_LINE_SIZE);
+    size_t dimm = location.channel * controller.getDimmsPerChannel() + location.dimm;
+    return dimm * banksPerDimm + (location.offset / rowBytes) % banksPerDimm;
+}
+
+size_t FlushScheduler::rowOf(size_t line) const {
+    return controller.mapAddress(line * CACHE_LINE_SIZE).offset / rowBytes / banksPerDimm;
+}
+
+std::vector<size_t> FlushScheduler::schedule(const std::vector<size_t> &lines) {
+    std::vector<size_t> order;
+    switch (policy) {
+    case FlushSchedulePolicy::FCFS:
+        order = lines;
+        break;
+    case FlushSchedulePolicy::AddressSorted:
+        order = lines;
+        std::stable_sort(order.begin(), order.end());
+        break;
+    case FlushSchedulePolicy::BankRoundRobin:
+        order = bankRoundRobin(lines);
+        break;
+    case FlushSchedulePolicy::FRFCFS:
+        order = firstReadyFCFS(lines);
+        break;
+    }
+    recordOrder(order);
+    return order;
+}
+
+// Takes the oldest remaining request of each bank in turn, spreading
+// consecutive flushes over as many banks as possible.
+std::vector<size_t> FlushScheduler::bankRoundRobin(const std::vector<size_t> &lines) const {
+    std::vector<std::deque<size_t>> perBank(numBanks);
+    for (size_t line : lines)
+        perBank[bankOf(line)].push_back(line);
+    std::vector<size_t> order;
+    order.reserve(lines.size());
+    while (order.size() < lines.size()) {
+        for (auto &queue : perBank) {
+            if (queue.empty())
+                continue;
+            order.push_back(queue.front());
+            queue.pop_front();
+        }
+    }
+    return order;
+}
+
+// First-ready FCFS: the oldest request hitting an open row goes first,
+// otherwise the oldest request overall. Requests are queued per bank and row,
+// so the oldest open-row hit is the smallest queue head in `ready`, which holds
+// at most one entry per bank.
+std::vector<size_t> FlushScheduler::firstReadyFCFS(const std::vector<size_t> &lines) const {
+    std::vector<size_t> bank(lines.size()), row(lines.size());
+    std::vector<std::unordered_map<size_t, std::deque<size_t>>> perBankRow(numBanks);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        bank[i] = bankOf(lines[i]);
+        row[i] = rowOf(lines[i]);
+        perBankRow[bank[i]][row[i]].push_back(i);
+    }
+    std::set<size_t> ready; // head of each bank's open-row queue, by batch position
+    std::vector<bool> issued(lines.size(), false);
+    std::vector<size_t> order;
+    order.reserve(lines.size());
+    size_t oldest = 0;
+    while (order.size() < lines.size()) {
+        size_t pick;
+        if (!ready.empty()) {
+            pick = *ready.begin();
+            ready.erase(ready.begin());
+        } else {
+            // No open row has requests left, so the oldest request opens a new one.
+            while (issued[oldest])
+                ++oldest;
+            pick = oldest;
+        }
+        auto &rows = perBankRow[bank[pick]];
+        auto queue = rows.find(row[pick]);
+        queue->second.pop_front();
+        if (queue->second.empty())
+            rows.erase(queue);
+        else
+            ready.insert(queue->second.front());
+        issued[pick] = true;
+        order.push_back(lines[pick]);
+    }
+    return order;
+}
+
+void FlushScheduler::recordOrder(const std::vector<size_t> &order) {
+    std::vector<size_t> openRow(numBanks, NO_OPEN_ROW);
+    size_t previousBlock = NO_OPEN_ROW;
+    for (size_t line : order) {
+        size_t bank = bankOf(line);
+        if (openRow[bank] == rowOf(line))
+            stats.rowHits++;
+        else
+            stats.rowMisses++;
+        openRow[bank] = rowOf(line);
+        size_t block = line * CACHE_LINE_SIZE / NVM_BLOCK_SIZE;
+        if (block == previousBlock)
+            stats.blockNeighbours++;
+        previousBlock = block;
+    }
+    stats.batches++;
+    stats.requests += order.size();
+}
+
+FlushSchedulePolicy FlushScheduler::getPolicy() const {
+    return policy;
+}
+
+FlushSchedulerStats& FlushScheduler::getStats() {
+    return stats;
+}
+
+void FlushScheduler::resetStats() {
+    stats.batches = 0;
+    stats.requests = 0;
+    stats.rowHits = 0;
+    stats.rowMisses = 0;
+    stats.blockNeighbours = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+
+class MemoryController;
+
+enum class FlushSchedulePolicy { FCFS, AddressSorted, BankRoundRobin, FRFCFS };
+
+std::string flushSchedulePolicyName(FlushSchedulePolicy policy);
+
+struct FlushSchedulerStats {
+    std::atomic<size_t> batches;
+    std::atomic<size_t> requests;
+    std::atomic<size_t> rowHits;        // request found its row already open in its bank
+    std::atomic<size_t> rowMisses;
+    std::atomic<size_t> blockNeighbours; // request shares a 256B media block with the previous one
+
+    FlushSchedulerStats() : batches(0), requests(0), rowHits(0), rowMisses(0), blockNeighbours(0) {}
+};
+
+// Reorders a batch of pending line flushes before they are issued to the
+// backing store. A batch never spans a fence, so any permutation of it is
+// legal. Lines map to a channel and DIMM through the controller's interleaving,
+// and within the DIMM to banksPerDimm banks with row-interleaved rows; the
+// stats replay the chosen order against one open row per bank.
+class FlushScheduler {
+public:
+    FlushScheduler(FlushSchedulePolicy policy, const MemoryController &controller,
+                   size_t banksPerDimm = 8, size_t rowBytes = 4096);
+
+    std::vector<size_t> schedule(const std::vector<size_t> &lines);
+    FlushSchedulePolicy getPolicy() const;
+    FlushSchedulerStats& getStats();
+    void resetStats();
+
+private:
+    size_t bankOf(size_t line) const;
+    size_t rowOf(size_t line) const;
+    std::vector<size_t> bankRoundRobin(const std::vector<size_t> &lines) const;
+    std::vector<size_t> firstReadyFCFS(const std::vector<size_t> &lines) const;
+    void recordOrder(const std::vector<size_t> &order);
+
+    FlushSchedulePolicy policy;
+    const MemoryController &controller;
+    size_t banksPerDimm;
+    size_t numBanks;
+    size_t rowBytes;
+    FlushSchedulerStats stats;
+};
@@ -0,0 +1,188 @@
+#include "huge_page_allocator.hpp"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+static const size_t SMALL_PAGE_SIZE = 4096;
+static const size_t MAX_ARENA_REGION = 64 * 1024 * 1024;
+
+static std::atomic<HugePageMode> hugePageMode(HugePageMode::Off);
+static std::atomic<bool> hugePagePrefault(false);
+static HugePageStats hugePageStats;
+
+HugePageMode hugePageModeFromString(const std::string &name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "off")
+        return HugePageMode::Off;
+    if (lower == "thp")
+        return HugePageMode::Transparent;
+    if (lower == "hugetlb")
+        return HugePageMode::Explicit;
+    throw std::invalid_argument("Unknown huge page mode: " + name);
+}
+
+std::string hugePageModeName(HugePageMode mode) {
+    switch (mode) {
+    case HugePageMode::Off: return "off";
+    case HugePageMode::Transparent: return "thp";
+    case HugePageMode::Explicit: return "hugetlb";
+    }
+    return "unknown";
+}
+
+void setHugePagePolicy(HugePageMode mode, bool prefault) {
+    hugePageMode = mode;
+    hugePagePrefault = prefault;
+}
+
+HugePageMode getHugePageMode() {
+    return hugePageMode;
+}
+
+HugePageStats& getHugePageStats() {
+    return hugePageStats;
+}
+
+size_t residentHugePageBytes() {
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(smaps, line)) {
+        if (line.compare(0, 14, "AnonHugePages:") != 0)
+            continue;
+        std::istringstream fields(line.substr(14));
+        size_t kilobytes = 0;
+        fields >> kilobytes;
+        return kilobytes * 1024;
+    }
+    return 0;
+}
+
+// Maps `length` bytes (a multiple of HUGE_PAGE_SIZE) starting on a
+// HUGE_PAGE_SIZE boundary, so the kernel can back it with whole huge pages.
+static void* mapAligned(size_t length) {
+    void *raw = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return MAP_FAILED;
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (aligned > start)
+        munmap(raw, aligned - start);
+    size_t tail = start + length + HUGE_PAGE_SIZE - (aligned + length);
+    if (tail > 0)
+        munmap(reinterpret_cast<void *>(aligned + length), tail);
+    return reinterpret_cast<void *>(aligned);
+}
+
+void* mapHugePageRegion(size_t bytes, size_t &mappedBytes) {
+    size_t length = std::max<size_t>((bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE, 1) * HUGE_PAGE_SIZE;
+    HugePageMode mode = hugePageMode;
+    bool prefault = hugePagePrefault;
+    void *region = MAP_FAILED;
+    bool populated = false;
+#ifdef MAP_HUGETLB
+    if (mode == HugePageMode::Explicit) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_POPULATE
+        if (prefault)
+            flags |= MAP_POPULATE;
+        populated = prefault;
+#endif
+        region = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (region != MAP_FAILED) {
+            hugePageStats.hugetlbRegions++;
+        } else {
+            // The hugetlbfs pool is empty or not configured.
+            hugePageStats.hugetlbFallbacks++;
+            mode = HugePageMode::Transparent;
+            populated = false;
+        }
+    }
+#else
+    if (mode == HugePageMode::Explicit)
+        mode = HugePageMode::Transparent;
+#endif
+    if (region == MAP_FAILED) {
+        if (mode == HugePageMode::Transparent) {
+            region = mapAligned(length);
+#ifdef MADV_HUGEPAGE
+            if (region != MAP_FAILED) {
+                madvise(region, length, MADV_HUGEPAGE);
+                hugePageStats.transparentRegions++;
+            }
+#endif
+        } else {
+            region = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+    }
+    if (region == MAP_FAILED)
+        throw std::bad_alloc();
+    if (prefault) {
+        // Touch one byte per small page; with THP the first touch of each
+        // 2MB extent faults in a whole huge page.
+        if (!populated) {
+            volatile char *bytesPtr = static_cast<char *>(region);
+            for (size_t offset = 0; offset < length; offset += SMALL_PAGE_SIZE)
+                bytesPtr[offset] = 0;
+        }
+        hugePageStats.bytesPrefaulted += length;
+    }
+    hugePageStats.regionsMapped++;
+    hugePageStats.bytesMapped += length;
+    mappedBytes = length;
+    return region;
+}
+
+void unmapHugePageRegion(void *region, size_t mappedBytes) {
+    munmap(region, mappedBytes);
+    hugePageStats.bytesMapped -= mappedBytes;
+}
+
+HugePageArena::HugePageArena() : cursor(nullptr), remaining(0), nextRegionBytes(HUGE_PAGE_SIZE) {}
+
+HugePageArena::~HugePageArena() {
+    for (auto &region : regions)
+        unmapHugePageRegion(region.first, region.second);
+}
+
+void HugePageArena::reserve(size_t bytes) {
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    if (bytes <= remaining)
+        return;
+    size_t mappedBytes;
+    void *region = mapHugePageRegion(bytes, mappedBytes);
+    regions.push_back({region, mappedBytes});
+    cursor = static_cast<char *>(region);
+    remaining = mappedBytes;
+}
+
+void* HugePageArena::allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    if (cursor == nullptr || padding + bytes > remaining) {
+        // Regions grow geometrically so sparse users map little up front.
+        size_t mappedBytes;
+        void *region = mapHugePageRegion(std::max(bytes, nextRegionBytes), mappedBytes);
+        regions.push_back({region, mappedBytes});
+        cursor = static_cast<char *>(region);
+        remaining = mappedBytes;
+        padding = 0;
+        nextRegionBytes = std::min(nextRegionBytes * 2, MAX_ARENA_REGION);
+    }
+    void *result = cursor + padding;
+    cursor += padding + bytes;
+    remaining -= padding + bytes;
+    return result;
+}
+
+size_t HugePageArena::bytesMapped() {
+    std::lock_guard<std::mutex> lock(arenaMutex);
+    size_t total = 0;
+    for (auto &region : regions)
+        total += region.second;
+    return total;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// How large simulator arrays are backed. Transparent maps 2MB-aligned
+// regions and madvises them for transparent huge pages. Explicit asks for
+// MAP_HUGETLB pages from the reserved pool and falls back to Transparent
+// when none are available. Off uses regular 4KB pages.
+enum class HugePageMode { Off, Transparent, Explicit };
+
+// Parses "off", "thp" or "hugetlb" (case-insensitive); throws std::invalid_argument otherwise.
+HugePageMode hugePageModeFromString(const std::string &name);
+std::string hugePageModeName(HugePageMode mode);
+
+struct HugePageStats {
+    std::atomic<size_t> regionsMapped;
+    std::atomic<size_t> bytesMapped;
+    std::atomic<size_t> hugetlbRegions;   // regions backed by MAP_HUGETLB
+    std::atomic<size_t> transparentRegions; // regions madvised for THP
+    std::atomic<size_t> hugetlbFallbacks; // MAP_HUGETLB requests that fell back to THP
+    std::atomic<size_t> bytesPrefaulted;
+
+    HugePageStats() : regionsMapped(0), bytesMapped(0), hugetlbRegions(0), transparentRegions(0), hugetlbFallbacks(0),
+                      bytesPrefaulted(0) {}
+};
+
+// Process-wide policy for the simulator's large arrays. Set it once at
+// startup, before caches are created. With prefault enabled every mapped
+// region is touched up front so page faults are paid at construction time
+// rather than during the measured run.
+void setHugePagePolicy(HugePageMode mode, bool prefault);
+HugePageMode getHugePageMode();
+HugePageStats& getHugePageStats();
+// Anonymous memory the kernel currently backs with huge pages, from
+// /proc/self/smaps_rollup (0 where unavailable).
+size_t residentHugePageBytes();
+
+// Maps a zero-filled region of at least `bytes` following the current
+// policy; `mappedBytes` receives the size to pass to unmapHugePageRegion.
+// Throws std::bad_alloc on failure.
+void* mapHugePageRegion(size_t bytes, size_t &mappedBytes);
+void unmapHugePageRegion(void *region, size_t mappedBytes);
+
+// Bump allocator over huge-page regions. Memory is released only when the
+// arena is destroyed, which suits arrays that live as long as their owner.
+class HugePageArena {
+public:
+    HugePageArena();
+    ~HugePageArena();
+    HugePageArena(const HugePageArena &) = delete;
+    HugePageArena& operator=(const HugePageArena &) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    // Makes sure the next `bytes` of allocations come from a single region.
+    void reserve(size_t bytes);
+    size_t bytesMapped();
+
+private:
+    std::mutex arenaMutex;
+    std::vector<std::pair<void *, size_t>> regions;
+    char *cursor;
+    size_t remaining;
+    size_t nextRegionBytes;
+};
+
+// STL allocator that places arrays of HUGE_PAGE_SIZE or more in their own
+// huge-page region and leaves smaller ones to operator new.
+template <typename T>
+struct HugePageAllocator {
+    using value_type = T;
+
+    HugePageAllocator() = default;
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U> &) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_SIZE)
+            return static_cast<T *>(::operator new(bytes));
+        size_t mappedBytes;
+        return static_cast<T *>(mapHugePageRegion(bytes, mappedBytes));
+    }
+
+    void deallocate(T *p, size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_SIZE)
+            ::operator delete(p);
+        else
+            unmapHugePageRegion(p, mappedSize(bytes));
+    }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const HugePageAllocator<U> &) const { return false; }
+
+private:
+    static size_t mappedSize(size_t bytes) {
+        return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+};
@@ -0,0 +1,107 @@
+#include "line_bitmap.hpp"
+#include "simd_kernels.hpp"
+
+LineBitmap::LineBitmap(size_t numBits) : numBits(0), allocatedChunks(0) {
+    resize(numBits);
+}
+
+void LineBitmap::resize(size_t bits) {
+    numBits = bits;
+    size_t numWords = (bits + 63) / 64;
+    chunks.clear();
+    chunks.resize((numWords + WORDS_PER_CHUNK - 1) / WORDS_PER_CHUNK);
+    summary.assign(chunks.size(), 0);
+    allocatedChunks = 0;
+}
+
+size_t LineBitmap::size() const {
+    return numBits;
+}
+
+bool LineBitmap::test(size_t index) const {
+    const auto &chunk = chunks[index / (64 * WORDS_PER_CHUNK)];
+    return chunk && ((chunk[index / 64 % WORDS_PER_CHUNK] >> (index % 64)) & 1);
+}
+
+void LineBitmap::set(size_t index) {
+    size_t w = index / 64;
+    auto &chunk = chunks[w / WORDS_PER_CHUNK];
+    if (!chunk) {
+        chunk.reset(new uint64_t[WORDS_PER_CHUNK]());
+        allocatedChunks++;
+    }
+    chunk[w % WORDS_PER_CHUNK] |= uint64_t(1) << (index % 64);
+    summary[w / WORDS_PER_CHUNK] |= uint64_t(1) << (w % WORDS_PER_CHUNK);
+}
+
+void LineBitmap::reset(size_t index) {
+    size_t w = index / 64;
+    auto &chunk = chunks[w / WORDS_PER_CHUNK];
+    if (!chunk)
+        return;
+    uint64_t &word = chunk[w % WORDS_PER_CHUNK];
+    word &= ~(uint64_t(1) << (index % 64));
+    if (word == 0)
+        summary[w / WORDS_PER_CHUNK] &= ~(uint64_t(1) << (w % WORDS_PER_CHUNK));
+}
+
+void LineBitmap::assign(size_t index, bool value) {
+    if (value)
+        set(index);
+    else
+        reset(index);
+}
+
+bool LineBitmap::any() const {
+    return simdAnyBitSet(summary.data(), summary.size());
+}
+
+size_t LineBitmap::count() const {
+    size_t total = 0;
+    for (size_t s = 0; s < chunks.size(); ++s) {
+        if (summary[s])
+            total += simdCountBits(chunks[s].get(), WORDS_PER_CHUNK);
+    }
+    return total;
+}
+
+size_t LineBitmap::findNext(size_t from) const {
+    if (from >= numBits)
+        return npos;
+    size_t w = from / 64;
+    if (chunks[w / WORDS_PER_CHUNK]) {
+        uint64_t word = chunks[w / WORDS_PER_CHUNK][w % WORDS_PER_CHUNK] & (~uint64_t(0) << (from % 64));
+        if (word)
+            return w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+    }
+    // Continue from the next word, skipping empty words through the summary.
+    size_t next = w + 1;
+    for (size_t s = next / WORDS_PER_CHUNK; s < summary.size(); ++s) {
+        uint64_t summaryWord = summary[s];
+        if (s == next / WORDS_PER_CHUNK)
+            summaryWord &= ~uint64_t(0) << (next % WORDS_PER_CHUNK);
+        if (summaryWord) {
+            size_t i = static_cast<size_t>(__builtin_ctzll(summaryWord));
+            return (s * WORDS_PER_CHUNK + i) * 64 + static_cast<size_t>(__builtin_ctzll(chunks[s][i]));
+        }
+    }
+    return npos;
+}
+
+// Chunks stay allocated so a bitmap that is repeatedly filled and cleared
+// does not churn the allocator.
+void LineBitmap::clearAll() {
+    for (size_t s = 0; s < summary.size(); ++s) {
+        uint64_t summaryWord = summary[s];
+        while (summaryWord) {
+            chunks[s][static_cast<size_t>(__builtin_ctzll(summaryWord))] = 0;
+            summaryWord &= summaryWord - 1;
+        }
+        summary[s] = 0;
+    }
+}
+
+size_t LineBitmap::allocatedBytes() const {
+    return allocatedChunks * WORDS_PER_CHUNK * sizeof(uint64_t) + chunks.size() * sizeof(chunks[0]) +
+           summary.size() * sizeof(uint64_t);
+}
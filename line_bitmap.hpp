@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Two-level bitmap over cache-line indices: one bit per line packed into
+// 64-bit words, plus a summary bit per word that is set while the word is
+// non-zero, so each summary word covers 4096 lines. Finding, iterating and
+// clearing set bits costs time proportional to the bits that are set rather
+// than to the number of lines; any() and count() scan the packed words with
+// the SIMD kernels in simd_kernels.hpp. The words behind each summary word
+// form a 512-byte chunk that is allocated the first time one of its bits is
+// set, so a sparse bitmap over billions of lines stays small.
+class LineBitmap {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit LineBitmap(size_t numBits = 0);
+
+    void resize(size_t numBits);
+    size_t size() const;
+    bool test(size_t index) const;
+    void set(size_t index);
+    void reset(size_t index);
+    void assign(size_t index, bool value);
+    bool any() const;
+    size_t count() const;
+    // First set bit at or after `from`, or npos.
+    size_t findNext(size_t from) const;
+    // Clears every set bit, visiting only summary words that are non-zero.
+    void clearAll();
+    size_t allocatedBytes() const;
+
+    template <typename Fn>
+    void forEach(Fn &&fn) const {
+        for (size_t s = 0; s < summary.size(); ++s) {
+            uint64_t summaryWord = summary[s];
+            while (summaryWord) {
+                size_t w = s * 64 + static_cast<size_t>(__builtin_ctzll(summaryWord));
+                summaryWord &= summaryWord - 1;
+                uint64_t word = chunks[s][w % 64];
+                while (word) {
+                    fn(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+
+    class const_iterator {
+    public:
+        const_iterator(const LineBitmap *bitmap, size_t index) : bitmap(bitmap), index(index) {}
+        size_t operator*() const { return index; }
+        const_iterator& operator++() {
+            index = bitmap->findNext(index + 1);
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        const LineBitmap *bitmap;
+        size_t index;
+    };
+
+    const_iterator begin() const { return const_iterator(this, findNext(0)); }
+    const_iterator end() const { return const_iterator(this, npos); }
+
+private:
+    static constexpr size_t WORDS_PER_CHUNK = 64;
+
+    size_t numBits;
+    std::vector<std::unique_ptr<uint64_t[]>> chunks; // chunks[s][i] is word s * 64 + i; bit b of word w is line w * 64 + b
+    std::vector<uint64_t> summary; // bit i of summary[s] is set while word s * 64 + i is non-zero
+    size_t allocatedChunks;
+};
@@ -0,0 +1,112 @@
+#include "memory_controller.hpp"
+#include <algorithm>
+#include <cmath>
+
+MemoryController::MemoryController(size_t wpqEntries, unsigned bandwidthMBps,
+                                   size_t numChannels, size_t dimmsPerChannel, size_t interleaveBytes)
+    : channels(std::max<size_t>(numChannels, 1)),
+      wpqEntries(std::max<size_t>(wpqEntries, 1)),
+      dimmsPerChannel(std::max<size_t>(dimmsPerChannel, 1)),
+      interleaveBytes((std::max(interleaveBytes, NVM_BLOCK_SIZE) + NVM_BLOCK_SIZE - 1) / NVM_BLOCK_SIZE * NVM_BLOCK_SIZE),
+      blockServiceMicros(static_cast<double>(NVM_BLOCK_SIZE) / std::max(bandwidthMBps, 1u)),
+      startTime(std::chrono::steady_clock::now()) {
+    for (auto &channel : channels)
+        channel.dimmBusyUntil.assign(this->dimmsPerChannel, 0.0);
+}
+
+void MemoryController::setClock(std::function<double()> clock) {
+    this->clock = std::move(clock);
+}
+
+double MemoryController::now() const {
+    if (clock)
+        return clock();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void MemoryController::retireDrained(Channel &channel, double time) {
+    while (!channel.wpq.empty() && channel.wpq.front().drainedAt <= time)
+        channel.wpq.pop_front();
+}
+
+NvmLocation MemoryController::mapAddress(size_t address) const {
+    size_t chunk = address / interleaveBytes;
+    size_t dimmChunk = chunk / channels.size() / dimmsPerChannel;
+    return {chunk % channels.size(), (chunk / channels.size()) % dimmsPerChannel,
+            dimmChunk * interleaveBytes + address % interleaveBytes};
+}
+
+unsigned MemoryController::submitFlush(size_t address) {
+    NvmLocation location = mapAddress(address);
+    auto &channel = channels[location.channel];
+    std::lock_guard<std::mutex> lock(channel.channelMutex);
+    double time = now();
+    retireDrained(channel, time);
+    stats.flushesReceived++;
+    channel.stats.flushesReceived++;
+
+    size_t block = address / NVM_BLOCK_SIZE;
+    for (const auto &pending : channel.wpq) {
+        if (pending.block == block) {
+            stats.combinedWrites++;
+            channel.stats.combinedWrites++;
+            return 0;
+        }
+    }
+
+    double stall = 0.0;
+    if (channel.wpq.size() >= wpqEntries) {
+        stall = channel.wpq.front().drainedAt - time;
+        time = channel.wpq.front().drainedAt;
+        retireDrained(channel, time);
+        stats.wpqFullStalls++;
+        channel.stats.wpqFullStalls++;
+    }
+
+    double &busyUntil = channel.dimmBusyUntil[location.dimm];
+    double start = std::max(time, busyUntil);
+    busyUntil = start + blockServiceMicros;
+    channel.wpq.push_back({block, busyUntil});
+    stats.mediaWrites++;
+    channel.stats.mediaWrites++;
+
+    unsigned stallMicros = static_cast<unsigned>(std::ceil(stall));
+    stats.stallMicros += stallMicros;
+    channel.stats.stallMicros += stallMicros;
+    return stallMicros;
+}
+
+static void resetStats(MemoryControllerStats &stats) {
+    stats.flushesReceived = 0;
+    stats.combinedWrites = 0;
+    stats.mediaWrites = 0;
+    stats.wpqFullStalls = 0;
+    stats.stallMicros = 0;
+}
+
+void MemoryController::reset() {
+    for (auto &channel : channels) {
+        std::lock_guard<std::mutex> lock(channel.channelMutex);
+        channel.wpq.clear();
+        std::fill(channel.dimmBusyUntil.begin(), channel.dimmBusyUntil.end(), 0.0);
+        resetStats(channel.stats);
+    }
+    startTime = std::chrono::steady_clock::now();
+    resetStats(stats);
+}
+
+MemoryControllerStats& MemoryController::getStats() {
+    return stats;
+}
+
+MemoryControllerStats& MemoryController::getChannelStats(size_t channel) {
+    return channels[channel].stats;
+}
+
+size_t MemoryController::getNumChannels() const {
+    return channels.size();
+}
+
+size_t MemoryController::getDimmsPerChannel() const {
+    return dimmsPerChannel;
+}
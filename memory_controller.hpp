@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Persistent memory DIMMs write their media in 256-byte blocks.
+constexpr size_t NVM_BLOCK_SIZE = 256;
+
+struct MemoryControllerStats {
+    std::atomic<size_t> flushesReceived;
+    std::atomic<size_t> combinedWrites;
+    std::atomic<size_t> mediaWrites;
+    std::atomic<size_t> wpqFullStalls;
+    std::atomic<size_t> stallMicros;
+
+    MemoryControllerStats() : flushesReceived(0), combinedWrites(0), mediaWrites(0), wpqFullStalls(0), stallMicros(0) {}
+};
+
+// Physical location of an address after channel/DIMM interleaving.
+struct NvmLocation {
+    size_t channel;
+    size_t dimm;
+    size_t offset; // byte offset within the DIMM
+};
+
+// Models the write path of a persistent memory controller. Addresses are
+// interleaved across channels and the DIMMs behind each channel in
+// interleaveBytes-sized chunks. Every channel has its own bounded write-pending
+// queue (WPQ); a line whose 256B block is already waiting in the queue is
+// combined into it, otherwise a new block is queued and drained to its DIMM's
+// media at the configured per-DIMM bandwidth. Once a channel's WPQ is full,
+// flushes to that channel stall until its oldest block has drained, while
+// flushes to other channels proceed independently.
+class MemoryController {
+public:
+    // bandwidthMBps is the media write bandwidth of one DIMM, i.e. bytes per
+    // simulated microsecond. interleaveBytes is rounded up to a whole 256B block.
+    MemoryController(size_t wpqEntries, unsigned bandwidthMBps,
+                     size_t numChannels = 1, size_t dimmsPerChannel = 1, size_t interleaveBytes = 4096);
+
+    // Accepts a flush of the line at the given byte address and returns how many
+    // microseconds the issuer stalls before the line is admitted to the WPQ.
+    unsigned submitFlush(size_t address);
+    NvmLocation mapAddress(size_t address) const;
+    void reset();
+    MemoryControllerStats& getStats();
+    // Per-channel view of the same counters.
+    MemoryControllerStats& getChannelStats(size_t channel);
+    size_t getNumChannels() const;
+    size_t getDimmsPerChannel() const;
+    // Time source, in microseconds, used to drain the WPQs. Defaults to wall
+    // time since construction; callers running caches under
+    // TimingModel::Accumulate should pass their simulated clock.
+    void setClock(std::function<double()> clock);
+
+private:
+    struct PendingBlock {
+        size_t block;
+        double drainedAt;
+    };
+
+    struct Channel {
+        std::mutex channelMutex;
+        std::deque<PendingBlock> wpq;
+        std::vector<double> dimmBusyUntil;
+        MemoryControllerStats stats;
+    };
+
+    double now() const;
+    static void retireDrained(Channel &channel, double time);
+
+    std::vector<Channel> channels;
+    size_t wpqEntries;
+    size_t dimmsPerChannel;
+    size_t interleaveBytes;
+    double blockServiceMicros;
+    std::chrono::steady_clock::time_point startTime;
+    std::function<double()> clock;
+    MemoryControllerStats stats;
+};
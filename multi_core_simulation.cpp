@@ -1,60 +1,182 @@
 #include "cache_simulator.hpp"
 #include "multi_level_cache.hpp"
+#include "memory_controller.hpp"
 #include "persistent_data_structure.hpp"
 #include "config.hpp"
 #include "ReadableFlexibleLogger.hpp"
+#include "numa_topology.hpp"
+#include "core_scheduler.hpp"
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <memory>
+#include <algorithm>
 
-void coreSimulation(int coreId, CacheSimulator &l1Cache, L2Cache &l2Cache, const Config &cfg, ReadableFlexibleLogger &logger) {
-    logger.log("Core " + std::to_string(coreId) + " simulation started.");
-    for (size_t i = 0; i < l1Cache.getCache().size(); ++i) {
-        l1Cache.writeLine(i, coreId * 1000 + i);
-        logger.log("Core " + std::to_string(coreId) + " wrote to line " + std::to_string(i));
-    }
-    for (size_t i = 0; i < l1Cache.getCache().size(); i += 2) {
-        if (l1Cache.flushLine(i, true))
-            logger.log("Core " + std::to_string(coreId) + " flushed line " + std::to_string(i));
-        int data = l1Cache.getCache()[i].data;
-        l2Cache.updateLineFromL1(i, data, false);
+static const int MAX_REPORTED_CORES = 16;
+
+// A simulated core's workload as a step-at-a-time program, so the task
+// scheduler can multiplex it: each step is one line write, one line flush or
+// one counter update. Thread mode runs it to completion (see coreSimulation).
+class CoreWorkload : public SimulatedCore {
+public:
+    CoreWorkload(int coreId, CacheSimulator &l1Cache, L2Cache &l2Cache, ReadableFlexibleLogger &logger)
+        : coreId(coreId), l1Cache(l1Cache), l2Cache(l2Cache), logger(logger), phase(Phase::Write), next(0) {}
+
+    bool step() override {
+        switch (phase) {
+        case Phase::Write:
+            if (next == 0)
+                logger.log("Core " + std::to_string(coreId) + " simulation started.");
+            l1Cache.writeLine(next, coreId * 1000 + next);
+            logger.log("Core " + std::to_string(coreId) + " wrote to line " + std::to_string(next));
+            if (++next == l1Cache.getNumLines()) {
+                phase = Phase::Flush;
+                next = 0;
+            }
+            return true;
+        case Phase::Flush:
+            if (l1Cache.flushLine(next, true))
+                logger.log("Core " + std::to_string(coreId) + " flushed line " + std::to_string(next));
+            l2Cache.updateLineFromL1(next, l1Cache.peekLine(next), false);
+            next += 2;
+            if (next >= l1Cache.getNumLines()) {
+                phase = Phase::Counter;
+                next = 0;
+                counter = std::make_unique<PersistentCounter>(l1Cache, 0);
+            }
+            return true;
+        case Phase::Counter:
+            counter->increment();
+            l1Cache.flushLine(0, true);
+            l2Cache.updateLineFromL1(0, l1Cache.peekLine(0), false);
+            l1Cache.memoryFence();
+            if (++next < 100)
+                return true;
+            logger.log("Core " + std::to_string(coreId) + " simulation completed.");
+            phase = Phase::Done;
+            return false;
+        case Phase::Done:
+            break;
+        }
+        return false;
     }
-    PersistentCounter counter(l1Cache, 0);
-    for (int i = 0; i < 100; ++i) {
-        counter.increment();
-        l1Cache.flushLine(0, true);
-        int data = l1Cache.getCache()[0].data;
-        l2Cache.updateLineFromL1(0, data, false);
-        l1Cache.memoryFence();
+
+private:
+    enum class Phase { Write, Flush, Counter, Done };
+
+    int coreId;
+    CacheSimulator &l1Cache;
+    L2Cache &l2Cache;
+    ReadableFlexibleLogger &logger;
+    Phase phase;
+    size_t next;
+    std::unique_ptr<PersistentCounter> counter;
+};
+
+void coreSimulation(int coreId, CacheSimulator &l1Cache, L2Cache &l2Cache, ReadableFlexibleLogger &logger) {
+    CoreWorkload workload(coreId, l1Cache, l2Cache, logger);
+    while (workload.step()) {
     }
-    logger.log("Core " + std::to_string(coreId) + " simulation completed.");
 }
 
 int main(int argc, char *argv[]) {
     Config cfg = Config::loadFromFile("config.json");
+    setHugePagePolicy(hugePageModeFromString(cfg.hugePages), cfg.prefaultMemory);
     ReadableFlexibleLogger logger("simulation.log");
 
+    MemoryController nvm(cfg.nvmWpqEntries, cfg.nvmBandwidthMBps,
+                         cfg.nvmChannels, cfg.nvmDimmsPerChannel, cfg.nvmInterleaveBytes);
     L2Cache sharedL2(cfg.l2Size);
-    std::vector<std::unique_ptr<CacheSimulator>> coreL1Caches;
-    for (int i = 0; i < cfg.numCores; ++i) {
+    sharedL2.setMemoryController(&nvm);
+    sharedL2.setPersistenceDomain(persistenceDomainFromString(cfg.persistenceDomain));
+    NumaTopology topology = NumaTopology::detect();
+    NumaPlacement placement = numaPlacementFromString(cfg.numaPlacement);
+    bool useTasks = cfg.coreScheduler == "tasks";
+    auto makeL1Cache = [&]() {
         auto cache = std::make_unique<CacheSimulator>(cfg.l1Size);
         cache->setFlushLatency(cfg.flushLatency);
         cache->setCleanLatency(cfg.cleanLatency);
         cache->setReadLatency(cfg.readLatency);
-        coreL1Caches.push_back(std::move(cache));
+        cache->setMemoryController(&nvm);
+        cache->setPersistenceDomain(persistenceDomainFromString(cfg.persistenceDomain));
+        cache->setFlushCoalescingWindow(cfg.flushCoalescingWindow);
+        if (useTasks)
+            cache->setTimingModel(TimingModel::Accumulate);
+        return cache;
+    };
+    std::vector<std::unique_ptr<CacheSimulator>> coreL1Caches(cfg.numCores);
+    std::vector<int> pinnedCpus(cfg.numCores, -1);
+    auto start = std::chrono::steady_clock::now();
+    if (useTasks) {
+        // Simulated cores become tasks on a small work-stealing pool, so
+        // numCores may far exceed the host's CPUs.
+        size_t workers = cfg.schedulerWorkers > 0 ? cfg.schedulerWorkers : std::max(1u, std::thread::hardware_concurrency());
+        sharedL2.setTimingModel(TimingModel::Accumulate);
+        CoreScheduler scheduler(workers);
+        // The shared controller drains on simulated time; the frontier never
+        // runs backwards however the cores interleave.
+        nvm.setClock([&scheduler]() { return static_cast<double>(scheduler.getSimulatedFrontier()); });
+        for (int coreId = 0; coreId < cfg.numCores; ++coreId) {
+            coreL1Caches[coreId] = makeL1Cache();
+            coreL1Caches[coreId]->setCoalescingClock([&scheduler]() { return scheduler.getSimulatedFrontier(); });
+            scheduler.addCore(std::make_unique<CoreWorkload>(coreId, *coreL1Caches[coreId], sharedL2, logger));
+        }
+        scheduler.run();
+        uint64_t longest = 0;
+        for (size_t coreId = 0; coreId < scheduler.getNumCores(); ++coreId)
+            longest = std::max(longest, scheduler.getSimulatedTime(coreId));
+        auto &schedStats = scheduler.getStats();
+        std::cout << cfg.numCores << " simulated cores on " << workers << " workers: " << schedStats.steps
+                  << " operations, " << schedStats.quanta << " quanta, " << schedStats.steals
+                  << " steals, longest core " << longest / 1000 << " ms simulated" << std::endl;
+    } else {
+        std::vector<std::thread> coreThreads;
+        for (int coreId = 0; coreId < cfg.numCores; ++coreId) {
+            coreThreads.emplace_back([&, coreId]() {
+                if (cfg.pinThreads && pinCurrentThread(topology.cpuForCore(coreId, placement)))
+                    pinnedCpus[coreId] = topology.cpuForCore(coreId, placement);
+                // Built on the core's own thread so first touch places its lines
+                // on the local NUMA node.
+                coreL1Caches[coreId] = makeL1Cache();
+                coreSimulation(coreId, *coreL1Caches[coreId], sharedL2, logger);
+            });
+        }
+        for (auto &t : coreThreads)
+            t.join();
     }
-    std::vector<std::thread> coreThreads;
-    for (int coreId = 0; coreId < cfg.numCores; ++coreId) {
-        coreThreads.emplace_back(coreSimulation, coreId, std::ref(*coreL1Caches[coreId]), std::ref(sharedL2), std::ref(cfg), std::ref(logger));
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Wall time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms" << std::endl;
+
+    int reportedCores = std::min(cfg.numCores, MAX_REPORTED_CORES);
+    std::cout << "Host NUMA nodes: " << topology.getNumNodes() << ", core threads "
+              << (useTasks ? std::string("multiplexed") : cfg.pinThreads ? "pinned (" + cfg.numaPlacement + ")" : std::string("unpinned")) << std::endl;
+    for (int coreId = 0; coreId < reportedCores && !useTasks; ++coreId) {
+        int cpu = pinnedCpus[coreId];
+        std::cout << "  Core " << coreId << ": CPU " << (cpu >= 0 ? std::to_string(cpu) : std::string("any"))
+                  << ", CPU node " << (cpu >= 0 ? std::to_string(topology.nodeOfCpu(cpu)) : std::string("-"))
+                  << ", cache memory node " << nodeOfAddress(coreL1Caches[coreId]->getLineStorage(0)) << std::endl;
     }
-    for (auto &t : coreThreads)
-        t.join();
 
     logger.log("Multi-core simulation completed.");
-    for (int coreId = 0; coreId < cfg.numCores; ++coreId) {
-        std::cout << "Core " << coreId << " flushes: " << coreL1Caches[coreId]->getStats().flushCount << std::endl;
+    for (int coreId = 0; coreId < reportedCores; ++coreId) {
+        auto &stats = coreL1Caches[coreId]->getStats();
+        std::cout << "Core " << coreId << " flushes: " << stats.flushCount
+                  << ", elided (" << cfg.persistenceDomain << "): " << stats.flushesElided
+                  << ", coalesced " << stats.flushesCoalesced << std::endl;
+    }
+    auto &nvmStats = nvm.getStats();
+    std::cout << "NVM flushes received: " << nvmStats.flushesReceived
+              << ", combined: " << nvmStats.combinedWrites
+              << ", media writes: " << nvmStats.mediaWrites
+              << ", WPQ full stalls: " << nvmStats.wpqFullStalls
+              << " (" << nvmStats.stallMicros << " us)" << std::endl;
+    for (size_t ch = 0; ch < nvm.getNumChannels(); ++ch) {
+        auto &chStats = nvm.getChannelStats(ch);
+        std::cout << "  Channel " << ch << ": flushes " << chStats.flushesReceived
+                  << ", media writes " << chStats.mediaWrites
+                  << ", stalls " << chStats.wpqFullStalls << std::endl;
     }
     return 0;
 }
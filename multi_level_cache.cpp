@@ -1,10 +1,12 @@
 #include "multi_level_cache.hpp"
+#include "memory_controller.hpp"
 #include <thread>
 #include <chrono>
 #include <iostream>
 
 L2Cache::L2Cache(size_t numLines)
-    : l2Lines(numLines) {}
+    : l2Lines(numLines), memoryController(nullptr), timingModel(TimingModel::Sleep),
+      persistenceDomain(PersistenceDomain::ADR) {}
 
 void L2Cache::writeLine(size_t index, int value) {
     std::lock_guard<std::mutex> lock(l2Mutex);
@@ -16,7 +18,12 @@ bool L2Cache::flushLine(size_t index) {
     std::lock_guard<std::mutex> lock(l2Mutex);
     auto &line = l2Lines[index];
     if (!line.dirty) return false;
-    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    if (persistenceDomain == PersistenceDomain::EADR) {
+        line.dirty = false;
+        return true;
+    }
+    unsigned stall = memoryController ? memoryController->submitFlush(index * CACHE_LINE_SIZE) : 0;
+    chargeLatency(timingModel, 200 + stall);
     line.dirty = false;
     std::cout << "[L2] Flushed line " << index << std::endl;
     return true;
@@ -34,6 +41,19 @@ void L2Cache::evictLine(size_t index) {
     std::cout << "[L2] Evicted line " << index << std::endl;
 }
 
-std::vector<L2Cache::L2Line>& L2Cache::getLines() {
+void L2Cache::setTimingModel(TimingModel model) {
+    timingModel = model;
+}
+
+void L2Cache::setPersistenceDomain(PersistenceDomain domain) {
+    std::lock_guard<std::mutex> lock(l2Mutex);
+    persistenceDomain = domain;
+}
+
+L2Cache::LineArray& L2Cache::getLines() {
     return l2Lines;
 }
+
+void L2Cache::setMemoryController(MemoryController *controller) {
+    memoryController = controller;
+}
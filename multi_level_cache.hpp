@@ -1,5 +1,6 @@
 #pragma once
 #include "cache_simulator.hpp"
+#include "huge_page_allocator.hpp"
 #include <vector>
 #include <mutex>
 
@@ -10,15 +11,24 @@ public:
         int data;
         L2Line() : dirty(false), data(0) {}
     };
+    using LineArray = std::vector<L2Line, HugePageAllocator<L2Line>>;
 
     L2Cache(size_t numLines);
     void writeLine(size_t index, int value);
     bool flushLine(size_t index);
     void updateLineFromL1(size_t index, int data, bool dirty);
     void evictLine(size_t index);
-    std::vector<L2Line>& getLines();
+    LineArray& getLines();
+    void setMemoryController(MemoryController *controller);
+    void setTimingModel(TimingModel model);
+    // Should match the L1s': under eADR the L2 is persistent too, so its
+    // flushes are elided like CacheSimulator's.
+    void setPersistenceDomain(PersistenceDomain domain);
 
 private:
-    std::vector<L2Line> l2Lines;
+    LineArray l2Lines;
     std::mutex l2Mutex;
+    MemoryController *memoryController;
+    TimingModel timingModel;
+    PersistenceDomain persistenceDomain;
 };
@@ -0,0 +1,134 @@
+#include "numa_topology.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+NumaPlacement numaPlacementFromString(const std::string &name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "spread")
+        return NumaPlacement::Spread;
+    if (lower == "compact")
+        return NumaPlacement::Compact;
+    throw std::invalid_argument("Unknown NUMA placement: " + name);
+}
+
+// Parses a kernel CPU list such as "0-3,8-11".
+static std::vector<int> parseCpuList(const std::string &text) {
+    std::vector<int> cpus;
+    std::stringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0])))
+            continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+NumaTopology NumaTopology::detect() {
+    NumaTopology topology;
+    for (int node = 0;; ++node) {
+        std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpuList)
+            break;
+        std::string text;
+        std::getline(cpuList, text);
+        topology.nodeCpus.push_back(parseCpuList(text));
+    }
+    if (topology.nodeCpus.empty()) {
+        std::vector<int> all;
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+            all.push_back(static_cast<int>(cpu));
+        topology.nodeCpus.push_back(all);
+    }
+    return topology;
+}
+
+size_t NumaTopology::getNumNodes() const {
+    return nodeCpus.size();
+}
+
+const std::vector<int>& NumaTopology::getNodeCpus(size_t node) const {
+    return nodeCpus[node];
+}
+
+int NumaTopology::nodeOfCpu(int cpu) const {
+    for (size_t node = 0; node < nodeCpus.size(); ++node) {
+        if (std::find(nodeCpus[node].begin(), nodeCpus[node].end(), cpu) != nodeCpus[node].end())
+            return static_cast<int>(node);
+    }
+    return -1;
+}
+
+int NumaTopology::cpuForCore(int coreId, NumaPlacement placement) const {
+    // Memory-only nodes have no CPUs and are skipped.
+    std::vector<const std::vector<int> *> nodes;
+    for (const auto &cpus : nodeCpus) {
+        if (!cpus.empty())
+            nodes.push_back(&cpus);
+    }
+    if (nodes.empty())
+        return 0;
+    if (placement == NumaPlacement::Spread) {
+        const auto &cpus = *nodes[coreId % nodes.size()];
+        return cpus[(coreId / nodes.size()) % cpus.size()];
+    }
+    size_t total = 0;
+    for (const auto *cpus : nodes)
+        total += cpus->size();
+    size_t slot = coreId % total;
+    for (const auto *cpus : nodes) {
+        if (slot < cpus->size())
+            return (*cpus)[slot];
+        slot -= cpus->size();
+    }
+    return 0;
+}
+
+bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+int currentCpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+int nodeOfAddress(const void *address) {
+#if defined(__linux__) && defined(SYS_move_pages)
+    // With a null node list move_pages only reports where each page lives.
+    void *page = const_cast<void *>(address);
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) != 0)
+        return -1;
+    return status >= 0 ? status : -1;
+#else
+    (void)address;
+    return -1;
+#endif
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// How simulated cores are spread over host CPUs when pinning is enabled.
+// Spread alternates NUMA nodes so every socket's memory bandwidth is used;
+// Compact fills one node's CPUs before moving to the next.
+enum class NumaPlacement { Spread, Compact };
+
+// Parses "spread" or "compact" (case-insensitive); throws std::invalid_argument otherwise.
+NumaPlacement numaPlacementFromString(const std::string &name);
+
+// Host NUMA layout read from /sys/devices/system/node. Hosts without that
+// directory (or non-Linux hosts) are treated as a single node holding every
+// CPU.
+class NumaTopology {
+public:
+    static NumaTopology detect();
+
+    size_t getNumNodes() const;
+    const std::vector<int>& getNodeCpus(size_t node) const;
+    // Node owning the CPU, or -1 if unknown.
+    int nodeOfCpu(int cpu) const;
+    // Host CPU for simulated core `coreId` under the given placement.
+    int cpuForCore(int coreId, NumaPlacement placement) const;
+
+private:
+    std::vector<std::vector<int>> nodeCpus;
+};
+
+// Pins the calling thread to one CPU. Returns false if pinning is not
+// supported or the CPU is not available to this process.
+bool pinCurrentThread(int cpu);
+// CPU the calling thread is running on, or -1 if unknown.
+int currentCpu();
+// NUMA node holding the page that contains `address`, or -1 if unknown
+// (queried with move_pages, so no libnuma is needed).
+int nodeOfAddress(const void *address);
@@ -0,0 +1,108 @@
+#include "pdes_simulation.hpp"
+#include <algorithm>
+#include <barrier>
+#include <stdexcept>
+#include <thread>
+
+L2Port::L2Port(EventEngine &engine, size_t partition, uint64_t lookahead)
+    : engine(engine), partition(partition), lookahead(lookahead), nextSequence(0) {}
+
+void L2Port::writeBack(size_t source, size_t line, int value) {
+    outbox.push_back({engine.now() + lookahead, partition, source, nextSequence++, line, value, nullptr, nullptr});
+}
+
+void L2Port::ReadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    port.outbox.push_back({port.engine.now() + port.lookahead, port.partition, source, port.nextSequence++, line, 0, this, handle});
+}
+
+PdesSimulation::PdesSimulation(size_t numPartitions, uint64_t lookahead, L2Cache &l2Cache)
+    : lookahead(lookahead), l2Cache(l2Cache), windowEnd(0), finished(false) {
+    if (lookahead == 0)
+        throw std::invalid_argument("PDES lookahead must be positive");
+    for (size_t p = 0; p < std::max<size_t>(numPartitions, 1); ++p) {
+        engines.push_back(std::make_unique<EventEngine>());
+        ports.push_back(std::make_unique<L2Port>(*engines.back(), p, lookahead));
+    }
+}
+
+size_t PdesSimulation::getNumPartitions() const {
+    return engines.size();
+}
+
+EventEngine& PdesSimulation::getEngine(size_t partition) {
+    return *engines[partition];
+}
+
+L2Port& PdesSimulation::getPort(size_t partition) {
+    return *ports[partition];
+}
+
+// Runs serially while every partition waits at the barrier: applies the
+// window's L2 messages in a fixed order and opens the next window. Returns
+// false once no partition has work left.
+bool PdesSimulation::finishWindow() {
+    std::vector<L2Port::Message> messages;
+    for (auto &port : ports) {
+        messages.insert(messages.end(), port->outbox.begin(), port->outbox.end());
+        port->outbox.clear();
+    }
+    std::sort(messages.begin(), messages.end(), [](const L2Port::Message &a, const L2Port::Message &b) {
+        if (a.time != b.time)
+            return a.time < b.time;
+        if (a.source != b.source)
+            return a.source < b.source;
+        return a.sequence < b.sequence;
+    });
+    for (const auto &message : messages) {
+        if (message.reader) {
+            message.reader->value = l2Cache.getLines()[message.line].data;
+            engines[message.partition]->scheduleAt(message.handle, message.time);
+        } else {
+            l2Cache.updateLineFromL1(message.line, message.value, true);
+        }
+    }
+    stats.messages += messages.size();
+
+    uint64_t earliest = EventEngine::NO_EVENT;
+    for (auto &engine : engines)
+        earliest = std::min(earliest, engine->nextEventTime());
+    if (earliest == EventEngine::NO_EVENT)
+        return false;
+    windowEnd = earliest + lookahead;
+    stats.windows++;
+    return true;
+}
+
+void PdesSimulation::run() {
+    finished = !finishWindow();
+    std::barrier windowBarrier(static_cast<std::ptrdiff_t>(engines.size()), [this]() noexcept {
+        finished = !finishWindow();
+    });
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < engines.size(); ++p) {
+        workers.emplace_back([this, p, &windowBarrier]() {
+            while (!finished) {
+                engines[p]->runUntil(windowEnd);
+                windowBarrier.arrive_and_wait();
+            }
+        });
+    }
+    for (auto &t : workers)
+        t.join();
+    stats.eventsProcessed = 0;
+    for (auto &engine : engines) {
+        stats.eventsProcessed += engine->getEventsProcessed();
+        engine->rethrowProgramFailures();
+    }
+}
+
+uint64_t PdesSimulation::now() const {
+    uint64_t latest = 0;
+    for (const auto &engine : engines)
+        latest = std::max(latest, engine->now());
+    return latest;
+}
+
+PdesStats& PdesSimulation::getStats() {
+    return stats;
+}
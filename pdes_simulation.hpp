@@ -0,0 +1,94 @@
+#pragma once
+#include "event_engine.hpp"
+#include "multi_level_cache.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A partition's link to the shared L2. Requests leave the partition as
+// timestamped messages that arrive `lookahead` simulated microseconds later;
+// they are applied to the L2 between windows in a fixed order. `source`
+// names the issuing simulated core; it breaks ties between messages that
+// arrive at the same time, so it must be unique across partitions.
+class L2Port {
+public:
+    L2Port(EventEngine &engine, size_t partition, uint64_t lookahead);
+
+    // Posted write-back of a line to the L2; the program continues at once.
+    void writeBack(size_t source, size_t line, int value);
+
+    struct ReadAwaiter {
+        L2Port &port;
+        size_t source;
+        size_t line;
+        int value;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        int await_resume() const noexcept { return value; }
+    };
+    // co_await port.read(line) resumes `lookahead` later with the L2's value.
+    ReadAwaiter read(size_t source, size_t line) { return ReadAwaiter{*this, source, line, 0}; }
+
+private:
+    friend class PdesSimulation;
+    struct Message {
+        uint64_t time; // arrival time at the L2
+        size_t partition;
+        size_t source;
+        uint64_t sequence;
+        size_t line;
+        int value;
+        ReadAwaiter *reader; // null for write-backs
+        std::coroutine_handle<> handle;
+    };
+
+    EventEngine &engine;
+    size_t partition;
+    uint64_t lookahead;
+    uint64_t nextSequence;
+    std::vector<Message> outbox;
+};
+
+struct PdesStats {
+    std::atomic<size_t> windows;
+    std::atomic<size_t> messages;
+    std::atomic<size_t> eventsProcessed;
+
+    PdesStats() : windows(0), messages(0), eventsProcessed(0) {}
+};
+
+// Parallel discrete-event simulation: simulated cores are spread over
+// partitions, each with its own EventEngine on its own host thread. The
+// partitions only interact through the shared L2, whose access latency is
+// the lookahead: in a window [T, T + lookahead), where T is the earliest
+// pending event anywhere, nothing a partition does can reach another one,
+// so every partition runs the window independently. At the barrier that
+// ends a window the L2 messages are applied in (time, source core, issue
+// order), which makes the result independent of the partition count and of
+// thread timing.
+class PdesSimulation {
+public:
+    PdesSimulation(size_t numPartitions, uint64_t lookahead, L2Cache &l2Cache);
+
+    size_t getNumPartitions() const;
+    EventEngine& getEngine(size_t partition);
+    L2Port& getPort(size_t partition);
+    // Runs every partition to completion.
+    void run();
+    // Simulated time of the last event in any partition.
+    uint64_t now() const;
+    PdesStats& getStats();
+
+private:
+    bool finishWindow();
+
+    uint64_t lookahead;
+    L2Cache &l2Cache;
+    std::vector<std::unique_ptr<EventEngine>> engines;
+    std::vector<std::unique_ptr<L2Port>> ports;
+    uint64_t windowEnd;
+    bool finished;
+    PdesStats stats;
+};
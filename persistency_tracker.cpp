@@ -0,0 +1,108 @@
+#include "persistency_tracker.hpp"
+#include <algorithm>
+
+static const size_t MAX_SAMPLES = 16;
+
+PersistencyTracker::PersistencyTracker() : redundantFlushes(0), orderingViolations(0) {}
+
+void PersistencyTracker::requirePersistOrder(size_t before, size_t after) {
+    predecessors.emplace(after, before);
+}
+
+uint32_t PersistencyTracker::currentThread() {
+    auto result = threadIds.emplace(std::this_thread::get_id(), static_cast<uint32_t>(threadFences.size()));
+    if (result.second)
+        threadFences.push_back(0);
+    return result.first->second;
+}
+
+bool PersistencyTracker::isDurable(size_t index) const {
+    auto it = lines.find(index);
+    if (it == lines.end())
+        return true;
+    const auto &line = it->second;
+    if (line.state == LineState::Clean)
+        return true;
+    if (line.state == LineState::Flushed)
+        return threadFences[line.flushThread] > line.flushFence;
+    return false;
+}
+
+// Callers check this before formatting a message, so findings past the cap
+// cost no allocation.
+bool PersistencyTracker::wantsSample() const {
+    return samples.size() < MAX_SAMPLES;
+}
+
+void PersistencyTracker::checkOrder(size_t index) {
+    if (predecessors.empty())
+        return;
+    auto range = predecessors.equal_range(index);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (isDurable(it->second))
+            continue;
+        orderingViolations++;
+        if (wantsSample())
+            samples.push_back("line " + std::to_string(index) + " persisted before line " +
+                              std::to_string(it->second) + " was flushed and fenced");
+    }
+}
+
+void PersistencyTracker::onStore(size_t index) {
+    lines[index].state = LineState::Stored;
+}
+
+void PersistencyTracker::onSilentStore(size_t index) {
+    auto it = lines.find(index);
+    if (it != lines.end() && it->second.state == LineState::Stored)
+        lines.erase(it);
+}
+
+void PersistencyTracker::onFlush(size_t index, bool wasDirty) {
+    auto &line = lines[index];
+    if (!wasDirty && line.state != LineState::Stored) {
+        redundantFlushes++;
+        if (wantsSample())
+            samples.push_back("redundant flush of clean line " + std::to_string(index));
+    }
+    checkOrder(index);
+    uint32_t thread = currentThread();
+    line.state = LineState::Flushed;
+    line.flushThread = thread;
+    line.flushFence = threadFences[thread];
+}
+
+void PersistencyTracker::onFence() {
+    threadFences[currentThread()]++;
+}
+
+void PersistencyTracker::onEvict(size_t index) {
+    checkOrder(index);
+    lines.erase(index);
+}
+
+void PersistencyTracker::reset() {
+    lines.clear();
+    threadIds.clear();
+    threadFences.clear();
+    redundantFlushes = 0;
+    orderingViolations = 0;
+    samples.clear();
+}
+
+PersistencyReport PersistencyTracker::report(bool storesDurable) const {
+    PersistencyReport result{0, 0, redundantFlushes, orderingViolations, samples};
+    std::vector<size_t> unflushed;
+    for (const auto &[index, line] : lines) {
+        if (line.state == LineState::Stored && !storesDurable)
+            unflushed.push_back(index);
+        else if (line.state == LineState::Flushed && !isDurable(index))
+            result.unfencedFlushes++;
+    }
+    result.unpersistedStores = unflushed.size();
+    // Lowest lines first, as a scan of the address space would find them.
+    std::sort(unflushed.begin(), unflushed.end());
+    for (size_t i = 0; i < unflushed.size() && result.samples.size() < MAX_SAMPLES; ++i)
+        result.samples.push_back("store to line " + std::to_string(unflushed[i]) + " never flushed");
+    return result;
+}
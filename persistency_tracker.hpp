@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct PersistencyReport {
+    size_t unpersistedStores;  // lines whose latest store was never flushed
+    size_t unfencedFlushes;    // lines flushed but not yet followed by a fence on the flushing thread
+    size_t redundantFlushes;   // flushes issued for lines that held no unpersisted data
+    size_t orderingViolations; // persists that overtook a declared predecessor
+    std::vector<std::string> samples; // first few findings, for debugging
+};
+
+// Records store/flush/fence order per thread for one CacheSimulator and flags
+// missing flushes, wasted flushes and persists that are not ordered by a fence
+// after a line recovery depends on. All hooks are O(1) and are called with the
+// owning cache's lock held, so the tracker needs no locking of its own. Only
+// lines that are not clean are tracked, so tracking a sparse cache costs
+// memory in proportion to the lines it touches.
+class PersistencyTracker {
+public:
+    PersistencyTracker();
+
+    // Declares that `after` must never reach the persistence domain before the
+    // latest store to `before` has been flushed and fenced.
+    void requirePersistOrder(size_t before, size_t after);
+
+    void onStore(size_t index);
+    void onSilentStore(size_t index);
+    void onFlush(size_t index, bool wasDirty);
+    void onFence();
+    void onEvict(size_t index);
+    void reset();
+    // With storesDurable (eADR) a store is persistent as soon as it is made,
+    // so unflushed stores are not reported.
+    PersistencyReport report(bool storesDurable) const;
+
+private:
+    enum class LineState : uint8_t { Clean, Stored, Flushed };
+
+    struct LineTrack {
+        LineState state = LineState::Clean;
+        uint32_t flushThread = 0;
+        uint64_t flushFence = 0; // flushing thread's fence count at flush time
+    };
+
+    uint32_t currentThread();
+    bool isDurable(size_t index) const;
+    void checkOrder(size_t index);
+    bool wantsSample() const;
+
+    std::unordered_map<size_t, LineTrack> lines; // absent lines are clean
+    std::unordered_multimap<size_t, size_t> predecessors; // after -> before
+    std::unordered_map<std::thread::id, uint32_t> threadIds;
+    std::vector<uint64_t> threadFences;
+    size_t redundantFlushes;
+    size_t orderingViolations;
+    std::vector<std::string> samples;
+};
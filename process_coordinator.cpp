@@ -0,0 +1,212 @@
+#include "process_coordinator.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+SharedMemoryRegion::SharedMemoryRegion(const std::string &name, size_t size)
+    : name(name), length(std::max<size_t>(size, 1)), mapping(nullptr) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throw std::runtime_error("shm_open " + name + ": " + std::strerror(errno));
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        int error = errno;
+        close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("ftruncate " + name + ": " + std::strerror(error));
+    }
+    mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("mmap " + name + ": " + std::strerror(errno));
+    }
+}
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    munmap(mapping, length);
+    shm_unlink(name.c_str());
+}
+
+void* SharedMemoryRegion::data() const {
+    return mapping;
+}
+
+size_t SharedMemoryRegion::size() const {
+    return length;
+}
+
+const std::string& SharedMemoryRegion::getName() const {
+    return name;
+}
+
+// Shared layout of the job region: a board followed by one slot per job.
+enum JobState : int { JOB_PENDING, JOB_RUNNING, JOB_DONE, JOB_FAILED };
+
+struct JobBoard {
+    std::atomic<size_t> nextJob;
+    size_t numJobs;
+};
+
+struct JobSlot {
+    std::atomic<int> state;
+    int worker; // pid of the worker that claimed the job
+    RunResult result;
+};
+
+static_assert(std::atomic<int>::is_always_lock_free && std::atomic<size_t>::is_always_lock_free,
+              "job board atomics must be lock-free to work across processes");
+
+static void workerMain(JobBoard *board, JobSlot *slots, const std::function<RunResult(size_t)> &job) {
+    for (;;) {
+        size_t index = board->nextJob.fetch_add(1);
+        if (index >= board->numJobs)
+            break;
+        JobSlot &slot = slots[index];
+        slot.worker = static_cast<int>(getpid());
+        slot.state.store(JOB_RUNNING, std::memory_order_release);
+        try {
+            slot.result = job(index);
+            slot.state.store(JOB_DONE, std::memory_order_release);
+        } catch (const std::exception &e) {
+            std::cerr << "Worker " << getpid() << ": job " << index << " failed: " << e.what() << std::endl;
+            slot.state.store(JOB_FAILED, std::memory_order_release);
+        }
+    }
+}
+
+ProcessCoordinator::ProcessCoordinator(size_t numWorkers)
+    : numWorkers(std::max<size_t>(numWorkers, 1)), traceSize(0), nextRegionId(0) {}
+
+void ProcessCoordinator::shareTrace(const std::vector<TraceOp> &trace) {
+    traceRegion.reset();
+    std::string name = "/skipcache-" + std::to_string(getpid()) + "-trace-" + std::to_string(nextRegionId++);
+    traceRegion = std::make_unique<SharedMemoryRegion>(name, trace.size() * sizeof(TraceOp));
+    std::copy(trace.begin(), trace.end(), static_cast<TraceOp *>(traceRegion->data()));
+    traceSize = trace.size();
+}
+
+const TraceOp* ProcessCoordinator::getTrace() const {
+    return traceRegion ? static_cast<const TraceOp *>(traceRegion->data()) : nullptr;
+}
+
+size_t ProcessCoordinator::getTraceSize() const {
+    return traceSize;
+}
+
+std::vector<JobOutcome> ProcessCoordinator::run(size_t numJobs, const std::function<RunResult(size_t)> &job) {
+    std::string name = "/skipcache-" + std::to_string(getpid()) + "-jobs-" + std::to_string(nextRegionId++);
+    SharedMemoryRegion region(name, sizeof(JobBoard) + numJobs * sizeof(JobSlot));
+    auto *board = new (region.data()) JobBoard{{0}, numJobs};
+    auto *slots = reinterpret_cast<JobSlot *>(static_cast<char *>(region.data()) + sizeof(JobBoard));
+    for (size_t i = 0; i < numJobs; ++i)
+        new (&slots[i]) JobSlot{{JOB_PENDING}, 0, RunResult{}};
+
+    // Unflushed output would otherwise be written once by every child too.
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::set<pid_t> workers;
+    auto forkWorker = [&]() {
+        pid_t pid = fork();
+        if (pid < 0)
+            throw std::runtime_error(std::string("fork: ") + std::strerror(errno));
+        if (pid == 0) {
+            workerMain(board, slots, job);
+            std::cout.flush();
+            _exit(0);
+        }
+        workers.insert(pid);
+        stats.workersForked++;
+    };
+    for (size_t w = 0; w < std::min(numWorkers, numJobs); ++w)
+        forkWorker();
+
+    std::vector<JobOutcome> outcomes(numJobs, JobOutcome{false, 0, RunResult{}});
+    while (!workers.empty()) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (workers.erase(pid) == 0)
+            continue;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            continue;
+        stats.workersCrashed++;
+        for (size_t i = 0; i < numJobs; ++i) {
+            if (slots[i].worker == pid && slots[i].state.load(std::memory_order_acquire) == JOB_RUNNING) {
+                slots[i].state.store(JOB_FAILED);
+                outcomes[i].signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+            }
+        }
+        if (board->nextJob.load() < numJobs)
+            forkWorker();
+    }
+
+    for (size_t i = 0; i < numJobs; ++i) {
+        outcomes[i].completed = slots[i].state.load(std::memory_order_acquire) == JOB_DONE;
+        if (outcomes[i].completed)
+            outcomes[i].result = slots[i].result;
+        else
+            stats.jobsFailed++;
+    }
+    return outcomes;
+}
+
+std::vector<JobOutcome> ProcessCoordinator::runConfigs(const std::vector<Config> &configs) {
+    const TraceOp *trace = getTrace();
+    size_t count = traceSize;
+    return run(configs.size(), [&](size_t job) { return runTraceSimulation(configs[job], trace, count); });
+}
+
+std::vector<JobOutcome> ProcessCoordinator::runAddressShards(const Config &cfg, size_t numShards) {
+    const TraceOp *trace = getTrace();
+    size_t count = traceSize;
+    numShards = std::max<size_t>(numShards, 1);
+    uint64_t indicesPerShard = std::max<uint64_t>((cfg.l1Size + numShards - 1) / numShards, 1);
+    return run(numShards, [&](size_t shard) {
+        return runTraceSimulation(cfg, trace, count, shard * indicesPerShard, (shard + 1) * indicesPerShard);
+    });
+}
+
+size_t ProcessCoordinator::getNumWorkers() const {
+    return numWorkers;
+}
+
+CoordinatorStats& ProcessCoordinator::getStats() {
+    return stats;
+}
+
+RunResult mergeResults(const std::vector<JobOutcome> &outcomes) {
+    RunResult merged{};
+    for (const auto &outcome : outcomes) {
+        if (!outcome.completed)
+            continue;
+        const RunResult &r = outcome.result;
+        merged.operations += r.operations;
+        merged.cores = std::max(merged.cores, r.cores);
+        for (uint32_t core = 0; core < r.cores; ++core)
+            merged.coreMicros[core] += r.coreMicros[core];
+        merged.flushes += r.flushes;
+        merged.flushesElided += r.flushesElided;
+        merged.wastedFlushes += r.wastedFlushes;
+        merged.lostPersists += r.lostPersists;
+        merged.l2WriteBacks += r.l2WriteBacks;
+        merged.mediaWrites += r.mediaWrites;
+        merged.wpqFullStalls += r.wpqFullStalls;
+        merged.readChecksum += r.readChecksum;
+        merged.wallMillis = std::max(merged.wallMillis, r.wallMillis);
+    }
+    merged.simulatedMicros = *std::max_element(merged.coreMicros, merged.coreMicros + MAX_RESULT_CORES);
+    return merged;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "config.hpp"
+#include "trace.hpp"
+#include "trace_simulation.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A named POSIX shared memory object (shm_open), mapped read/write. The
+// creating process unlinks the name on destruction; mappings inherited by
+// forked children stay valid.
+class SharedMemoryRegion {
+public:
+    // Throws std::runtime_error if the object cannot be created or mapped.
+    SharedMemoryRegion(const std::string &name, size_t size);
+    ~SharedMemoryRegion();
+    SharedMemoryRegion(const SharedMemoryRegion &) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion &) = delete;
+
+    void* data() const;
+    size_t size() const;
+    const std::string& getName() const;
+
+private:
+    std::string name;
+    size_t length;
+    void *mapping;
+};
+
+struct JobOutcome {
+    bool completed;
+    int signal; // signal that killed the worker running the job, 0 if none
+    RunResult result;
+};
+
+struct CoordinatorStats {
+    std::atomic<size_t> workersForked;
+    std::atomic<size_t> workersCrashed;
+    std::atomic<size_t> jobsFailed;
+
+    CoordinatorStats() : workersForked(0), workersCrashed(0), jobsFailed(0) {}
+};
+
+// Scales simulations out over forked worker processes on one host. The trace
+// is copied once into shared memory and read by every worker in place; jobs
+// are claimed from a shared counter and results are written to per-job
+// slots in a second shared region. A worker that crashes only loses the job
+// it was running: the job is reported as failed and a replacement worker is
+// forked if jobs remain.
+class ProcessCoordinator {
+public:
+    explicit ProcessCoordinator(size_t numWorkers);
+
+    // Copies the trace into shared memory for the workers.
+    void shareTrace(const std::vector<TraceOp> &trace);
+    const TraceOp* getTrace() const;
+    size_t getTraceSize() const;
+
+    // Runs job(0) ... job(numJobs - 1) in worker processes; blocks until all
+    // are done or failed. `job` runs in the child, so side effects other
+    // than its result are not seen by the caller.
+    std::vector<JobOutcome> run(size_t numJobs, const std::function<RunResult(size_t job)> &job);
+    // One job per configuration, each replaying the whole shared trace.
+    std::vector<JobOutcome> runConfigs(const std::vector<Config> &configs);
+    // One job per address shard: the L1 index space [0, cfg.l1Size) is split
+    // into numShards contiguous ranges and each worker replays only the
+    // operations that map into its range. Shards share no cache lines; only
+    // WPQ write combining across shards is lost.
+    std::vector<JobOutcome> runAddressShards(const Config &cfg, size_t numShards);
+
+    size_t getNumWorkers() const;
+    CoordinatorStats& getStats();
+
+private:
+    size_t numWorkers;
+    std::unique_ptr<SharedMemoryRegion> traceRegion;
+    size_t traceSize;
+    size_t nextRegionId;
+    CoordinatorStats stats;
+};
+
+// Merges the address shards of one replay: counters are summed and so is
+// each core's simulated time, as every shard ran a part of each core's
+// operations; simulatedMicros is the longest merged core time. wallMillis
+// takes the maximum, as the jobs ran side by side.
+RunResult mergeResults(const std::vector<JobOutcome> &outcomes);
@@ -0,0 +1,97 @@
+#include "result_cache.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+#ifndef SIMULATION_BUILD_ID
+#define SIMULATION_BUILD_ID "built " __DATE__ " " __TIME__
+#endif
+
+const char* simulationBuildId() {
+    return SIMULATION_BUILD_ID;
+}
+
+uint64_t fnv1a64(const void *data, size_t length, uint64_t hash) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t fnv1a64(const std::string &text) {
+    return fnv1a64(text.data(), text.size());
+}
+
+uint64_t hashTrace(const std::vector<TraceOp> &trace) {
+    uint64_t hash = fnv1a64(nullptr, 0);
+    for (const auto &op : trace) {
+        auto type = static_cast<uint8_t>(op.type);
+        hash = fnv1a64(&type, sizeof(type), hash);
+        hash = fnv1a64(&op.core, sizeof(op.core), hash);
+        hash = fnv1a64(&op.line, sizeof(op.line), hash);
+        hash = fnv1a64(&op.value, sizeof(op.value), hash);
+    }
+    return hash;
+}
+
+ResultCache::ResultCache(const std::string &directory) : directory(directory) {
+    std::filesystem::create_directories(directory);
+}
+
+json ResultCache::makeKey(const Config &cfg, const json &workload) {
+    return json{{"config", cfg.toJson()}, {"workload", workload}, {"build", simulationBuildId()}};
+}
+
+std::string ResultCache::pathFor(const json &key) const {
+    // dump() of nlohmann::json sorts object keys, so the key text is canonical.
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(fnv1a64(key.dump())));
+    return directory + "/" + name;
+}
+
+bool ResultCache::lookup(const Config &cfg, const json &workload, RunResult &result) {
+    json key = makeKey(cfg, workload);
+    std::ifstream in(pathFor(key));
+    json entry = in ? json::parse(in, nullptr, false) : json();
+    if (entry.is_discarded() || !entry.is_object() || entry.value("key", json()) != key || !entry.contains("result")) {
+        stats.misses++;
+        return false;
+    }
+    try {
+        result = runResultFromJson(entry["result"]);
+    } catch (const json::exception &) {
+        stats.misses++;
+        return false;
+    }
+    stats.hits++;
+    return true;
+}
+
+void ResultCache::store(const Config &cfg, const json &workload, const RunResult &result) {
+    json key = makeKey(cfg, workload);
+    std::string path = pathFor(key);
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temporary);
+        if (!out)
+            return;
+        out << json{{"key", key}, {"result", runResultToJson(result)}}.dump(2) << '\n';
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+    else
+        stats.stores++;
+}
+
+const std::string& ResultCache::getDirectory() const {
+    return directory;
+}
+
+ResultCacheStats& ResultCache::getStats() {
+    return stats;
+}
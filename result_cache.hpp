@@ -0,0 +1,54 @@
+#pragma once
+#include "config.hpp"
+#include "trace.hpp"
+#include "trace_simulation.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 64-bit FNV-1a.
+uint64_t fnv1a64(const void *data, size_t length, uint64_t hash = 0xcbf29ce484222325ull);
+uint64_t fnv1a64(const std::string &text);
+// Hash of a trace's operations, field by field (independent of padding).
+uint64_t hashTrace(const std::vector<TraceOp> &trace);
+
+struct ResultCacheStats {
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+    std::atomic<size_t> stores;
+
+    ResultCacheStats() : hits(0), misses(0), stores(0) {}
+};
+
+// Identifies the simulator sources this binary was built from. The Makefile
+// passes a hash of every unified_sim source and header as
+// SIMULATION_BUILD_ID, so any change to simulation code invalidates cached
+// results; builds without it fall back to the compile time of this file.
+const char* simulationBuildId();
+
+// On-disk memo of completed runs, one JSON file per run in `directory`.
+// A run is keyed by the full effective Config (canonical JSON), a
+// description of its workload and the simulator build (see
+// simulationBuildId); the file name
+// is the FNV-1a hash of that key, and the stored key is compared on lookup
+// so a hash collision reads as a miss.
+class ResultCache {
+public:
+    // Creates the directory if needed.
+    explicit ResultCache(const std::string &directory);
+
+    bool lookup(const Config &cfg, const json &workload, RunResult &result);
+    // Written to a temporary file and renamed, so concurrent sweeps never
+    // read a partial entry.
+    void store(const Config &cfg, const json &workload, const RunResult &result);
+    const std::string& getDirectory() const;
+    ResultCacheStats& getStats();
+
+private:
+    static json makeKey(const Config &cfg, const json &workload);
+    std::string pathFor(const json &key) const;
+
+    std::string directory;
+    ResultCacheStats stats;
+};
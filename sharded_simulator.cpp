@@ -0,0 +1,155 @@
+#include "sharded_simulator.hpp"
+#include "sim_timing.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Requests an owner takes from one queue before moving to the next.
+static const size_t OWNER_BATCH = 64;
+
+ShardedSimulator::ShardedSimulator(size_t numShards, size_t numLines, size_t numProducers, size_t queueCapacity)
+    : numProducers(std::max<size_t>(numProducers, 1)) {
+    if (numShards == 0 || numLines == 0)
+        throw std::invalid_argument("ShardedSimulator needs at least one shard and one line");
+    linesPerShard = (numLines + numShards - 1) / numShards;
+    for (size_t s = 0; s < numShards; ++s) {
+        auto shard = std::make_unique<Shard>();
+        size_t lines = std::min(linesPerShard, numLines - std::min(numLines, s * linesPerShard));
+        shard->l1 = std::make_unique<CacheSimulator>(std::max<size_t>(lines, 1));
+        shard->l2 = std::make_unique<L2Cache>(std::max<size_t>(lines, 1));
+        shard->l1->setTimingModel(TimingModel::Accumulate);
+        shard->l2->setTimingModel(TimingModel::Accumulate);
+        for (size_t p = 0; p < this->numProducers; ++p)
+            shard->inbound.push_back(std::make_unique<SpscQueue<Request>>(queueCapacity));
+        shards.push_back(std::move(shard));
+    }
+}
+
+ShardedSimulator::~ShardedSimulator() {
+    join();
+}
+
+size_t ShardedSimulator::getNumShards() const {
+    return shards.size();
+}
+
+size_t ShardedSimulator::getNumProducers() const {
+    return numProducers;
+}
+
+size_t ShardedSimulator::shardOf(uint64_t line) const {
+    return std::min<size_t>(line / linesPerShard, shards.size() - 1);
+}
+
+uint64_t ShardedSimulator::offsetInShard(uint64_t line) const {
+    return line - shardOf(line) * linesPerShard;
+}
+
+CacheSimulator& ShardedSimulator::getL1(size_t shard) {
+    return *shards[shard]->l1;
+}
+
+L2Cache& ShardedSimulator::getL2(size_t shard) {
+    return *shards[shard]->l2;
+}
+
+void ShardedSimulator::start() {
+    for (size_t s = 0; s < shards.size(); ++s)
+        shards[s]->owner = std::thread(&ShardedSimulator::ownerLoop, this, s);
+}
+
+void ShardedSimulator::push(size_t producer, size_t shard, const Request &request) {
+    auto &queue = *shards[shard]->inbound[producer];
+    while (!queue.tryPush(request))
+        std::this_thread::yield();
+}
+
+void ShardedSimulator::submit(size_t producer, const TraceOp &op) {
+    size_t shard = shardOf(op.line);
+    Request request{Request::Kind::Write, offsetInShard(op.line), op.value};
+    if (op.type == TraceOp::Type::Flush)
+        request.kind = Request::Kind::Flush;
+    else if (op.type == TraceOp::Type::Read)
+        request.kind = Request::Kind::Read;
+    push(producer, shard, request);
+}
+
+void ShardedSimulator::closeProducer(size_t producer) {
+    for (size_t s = 0; s < shards.size(); ++s)
+        push(producer, s, {Request::Kind::Stop, 0, 0});
+}
+
+void ShardedSimulator::join() {
+    for (auto &shard : shards) {
+        if (shard->owner.joinable())
+            shard->owner.join();
+    }
+}
+
+void ShardedSimulator::replay(const std::vector<TraceOp> &trace) {
+    start();
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < numProducers; ++p) {
+        producers.emplace_back([this, p, &trace]() {
+            for (const auto &op : trace) {
+                if (op.core % numProducers == p)
+                    submit(p, op);
+            }
+            closeProducer(p);
+        });
+    }
+    for (auto &t : producers)
+        t.join();
+    join();
+}
+
+ShardStats& ShardedSimulator::getStats(size_t shard) {
+    return shards[shard]->stats;
+}
+
+// Counters stay in locals while the owner runs and are published once at
+// the end, so the hot loop performs no atomic read-modify-writes.
+void ShardedSimulator::ownerLoop(size_t s) {
+    Shard &shard = *shards[s];
+    size_t writes = 0, flushes = 0, reads = 0, writeBacks = 0;
+    uint64_t simulated = 0, checksum = 0;
+    size_t open = numProducers;
+    consumeChargedLatency();
+    while (open > 0) {
+        bool idle = true;
+        for (auto &queue : shard.inbound) {
+            Request request;
+            for (size_t n = 0; n < OWNER_BATCH && queue->tryPop(request); ++n) {
+                idle = false;
+                switch (request.kind) {
+                case Request::Kind::Write:
+                    shard.l1->writeLine(request.line, request.value);
+                    writes++;
+                    break;
+                case Request::Kind::Flush:
+                    if (shard.l1->flushLine(request.line, true)) {
+                        shard.l2->updateLineFromL1(request.line, shard.l1->peekLine(request.line), false);
+                        writeBacks++;
+                    }
+                    flushes++;
+                    break;
+                case Request::Kind::Read:
+                    checksum += static_cast<unsigned>(shard.l1->readLine(request.line));
+                    reads++;
+                    break;
+                case Request::Kind::Stop:
+                    open--;
+                    break;
+                }
+            }
+        }
+        simulated += consumeChargedLatency();
+        if (idle)
+            std::this_thread::yield();
+    }
+    shard.stats.writes = writes;
+    shard.stats.flushes = flushes;
+    shard.stats.reads = reads;
+    shard.stats.l2WriteBacks = writeBacks;
+    shard.stats.simulatedMicros = simulated;
+    shard.stats.readChecksum = checksum;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "cache_simulator.hpp"
+#include "multi_level_cache.hpp"
+#include "spsc_queue.hpp"
+#include "trace.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct ShardStats {
+    std::atomic<size_t> writes;
+    std::atomic<size_t> flushes;
+    std::atomic<size_t> reads;
+    std::atomic<size_t> l2WriteBacks;
+    std::atomic<uint64_t> simulatedMicros; // latency charged by this shard's caches
+    std::atomic<uint64_t> readChecksum;    // sum of values read
+
+    ShardStats() : writes(0), flushes(0), reads(0), l2WriteBacks(0), simulatedMicros(0), readChecksum(0) {}
+};
+
+// Owner-computes simulator: the line index space is split into contiguous
+// ranges, one per shard, and each shard's L1 and L2 slices are touched only
+// by that shard's owner thread. Producers route each operation to the owning
+// shard through a dedicated SPSC queue per (producer, shard) pair, so the
+// data path shares no locks or cache lines between threads. Operations from
+// one producer to one shard are applied in submission order.
+class ShardedSimulator {
+public:
+    ShardedSimulator(size_t numShards, size_t numLines, size_t numProducers, size_t queueCapacity = 4096);
+    // Joins the owners, so every producer must be closed once started.
+    ~ShardedSimulator();
+    ShardedSimulator(const ShardedSimulator &) = delete;
+    ShardedSimulator& operator=(const ShardedSimulator &) = delete;
+
+    size_t getNumShards() const;
+    size_t getNumProducers() const;
+    size_t shardOf(uint64_t line) const;
+    // Index of `line` within its shard's caches.
+    uint64_t offsetInShard(uint64_t line) const;
+    // Per-shard caches, indexed by line offset within the shard. Configure
+    // them before start(); afterwards only the owner thread may use them.
+    CacheSimulator& getL1(size_t shard);
+    L2Cache& getL2(size_t shard);
+
+    // Launches one owner thread per shard.
+    void start();
+    // Routes an operation to its shard; waits while that queue is full.
+    // Each producer index must be used by a single thread.
+    void submit(size_t producer, const TraceOp &op);
+    // Signals that `producer` will submit nothing more.
+    void closeProducer(size_t producer);
+    // Waits for every owner to drain its queues; call after all producers
+    // are closed.
+    void join();
+    // start(), then one thread per producer submitting the operations of
+    // cores with core % numProducers == producer, then join().
+    void replay(const std::vector<TraceOp> &trace);
+
+    ShardStats& getStats(size_t shard);
+
+private:
+    struct Request {
+        enum class Kind : uint8_t { Write, Flush, Read, Stop };
+        Kind kind;
+        uint64_t line; // offset within the shard
+        int value;
+    };
+    struct Shard {
+        std::unique_ptr<CacheSimulator> l1;
+        std::unique_ptr<L2Cache> l2;
+        std::vector<std::unique_ptr<SpscQueue<Request>>> inbound; // one per producer
+        ShardStats stats;
+        std::thread owner;
+    };
+
+    void push(size_t producer, size_t shard, const Request &request);
+    void ownerLoop(size_t shard);
+
+    size_t linesPerShard;
+    size_t numProducers;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
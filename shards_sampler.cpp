@@ -0,0 +1,116 @@
+#include "shards_sampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ShardsSampler::ShardsSampler(double rate, size_t maxLines)
+    : maxLines(maxLines), accesses(0), sampledAccesses(0), coldSamples(0), sampleWeight(1.0) {
+    if (rate <= 0.0 || rate > 1.0)
+        throw std::invalid_argument("SHARDS sampling rate must be in (0, 1]");
+    threshold = std::max<uint64_t>(static_cast<uint64_t>(std::llround(rate * HASH_MODULUS)), 1);
+}
+
+// splitmix64 finalizer: neighbouring lines land on unrelated hashes.
+uint64_t ShardsSampler::hashLine(uint64_t line) {
+    line += 0x9e3779b97f4a7c15ull;
+    line = (line ^ (line >> 30)) * 0xbf58476d1ce4e5b9ull;
+    line = (line ^ (line >> 27)) * 0x94d049bb133111ebull;
+    return (line ^ (line >> 31)) % HASH_MODULUS;
+}
+
+void ShardsSampler::access(uint64_t line) {
+    accesses++;
+    uint64_t hash = hashLine(line);
+    if (hash >= threshold)
+        return;
+    sampledAccesses++;
+    uint64_t distance = analyzer.access(line);
+    if (distance == StackDistanceAnalyzer::COLD) {
+        coldSamples += sampleWeight;
+        if (maxLines > 0) {
+            trackedByHash.emplace(hash, line);
+            if (trackedByHash.size() > maxLines)
+                shrinkSample();
+        }
+        return;
+    }
+    scaledHistogram[static_cast<uint64_t>(std::llround(distance / getRate()))] += sampleWeight;
+}
+
+// References counted at the old rate must count R_new / R_old as much as
+// new ones. Rather than rescaling the whole histogram, later references are
+// weighted up by the inverse and the weight is divided out when reading.
+void ShardsSampler::shrinkSample() {
+    double oldRate = getRate();
+    threshold = trackedByHash.top().first;
+    sampleWeight *= oldRate / getRate();
+    while (!trackedByHash.empty() && trackedByHash.top().first >= threshold) {
+        analyzer.forget(trackedByHash.top().second);
+        trackedByHash.pop();
+    }
+}
+
+void ShardsSampler::processTrace(const std::vector<TraceOp> &trace) {
+    for (const auto &op : trace) {
+        if (op.type != TraceOp::Type::Flush)
+            access(op.line);
+    }
+}
+
+double ShardsSampler::getRate() const {
+    return static_cast<double>(threshold) / HASH_MODULUS;
+}
+
+uint64_t ShardsSampler::getAccesses() const {
+    return accesses;
+}
+
+uint64_t ShardsSampler::getSampledAccesses() const {
+    return sampledAccesses;
+}
+
+size_t ShardsSampler::getTrackedLines() const {
+    return analyzer.getDistinctLines();
+}
+
+double ShardsSampler::missRatio(uint64_t cacheLines) const {
+    return missRatioCurve({cacheLines}).front().second;
+}
+
+std::vector<std::pair<uint64_t, double>> ShardsSampler::missRatioCurve(const std::vector<uint64_t> &cacheSizes) const {
+    double total = coldSamples / sampleWeight;
+    for (const auto &[distance, count] : scaledHistogram)
+        total += count / sampleWeight;
+    // SHARDS_adj: in fixed-rate mode the sample may hold more or fewer
+    // references than accesses * R; the difference is credited to the
+    // smallest distance, i.e. counted as hits for every cache size.
+    double adjustment = maxLines == 0 ? accesses * getRate() - total : 0.0;
+    total += adjustment;
+
+    std::vector<uint64_t> sorted(cacheSizes);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::pair<uint64_t, double>> curve;
+    double hitCount = adjustment;
+    auto it = scaledHistogram.begin();
+    for (uint64_t size : sorted) {
+        for (; it != scaledHistogram.end() && it->first <= size; ++it)
+            hitCount += it->second / sampleWeight;
+        double ratio = total > 0 ? (total - hitCount) / total : 0.0;
+        curve.emplace_back(size, std::clamp(ratio, 0.0, 1.0));
+    }
+    return curve;
+}
+
+MrcError compareMissRatioCurves(const std::vector<std::pair<uint64_t, double>> &exact,
+                                const std::vector<std::pair<uint64_t, double>> &approximate) {
+    MrcError error{0.0, 0.0};
+    size_t points = std::min(exact.size(), approximate.size());
+    for (size_t i = 0; i < points; ++i) {
+        double difference = std::fabs(exact[i].second - approximate[i].second);
+        error.meanAbsolute += difference;
+        error.maxAbsolute = std::max(error.maxAbsolute, difference);
+    }
+    if (points > 0)
+        error.meanAbsolute /= points;
+    return error;
+}
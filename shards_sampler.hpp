@@ -0,0 +1,63 @@
+#pragma once
+#include "stack_distance.hpp"
+#include "trace.hpp"
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Approximate miss-ratio curves by spatially hashed sampling (SHARDS,
+// Waldspurger et al., FAST '15). A line is sampled when hash(line) mod P is
+// below a threshold T, so every access to a sampled line is seen and the
+// sample is a uniform fraction R = T / P of the address space. Stack
+// distances among sampled lines are scaled by 1 / R to estimate distances in
+// the full trace.
+//
+// With maxLines == 0 the rate is fixed and the histogram is adjusted for
+// the difference between expected (accesses * R) and sampled reference
+// counts. Otherwise at most maxLines lines are tracked: when the sample
+// outgrows that, T drops to the largest tracked hash, lines at or above it
+// are evicted and the histogram is rescaled to the new rate, so memory stays
+// bounded however large the trace.
+class ShardsSampler {
+public:
+    static constexpr uint64_t HASH_MODULUS = 1 << 24;
+
+    ShardsSampler(double rate, size_t maxLines = 0);
+
+    void access(uint64_t line);
+    // Reads and writes, as in StackDistanceAnalyzer::processTrace.
+    void processTrace(const std::vector<TraceOp> &trace);
+
+    double getRate() const;
+    uint64_t getAccesses() const;
+    uint64_t getSampledAccesses() const;
+    size_t getTrackedLines() const;
+    double missRatio(uint64_t cacheLines) const;
+    std::vector<std::pair<uint64_t, double>> missRatioCurve(const std::vector<uint64_t> &cacheSizes) const;
+
+private:
+    static uint64_t hashLine(uint64_t line);
+    void shrinkSample();
+
+    uint64_t threshold;
+    size_t maxLines;
+    StackDistanceAnalyzer analyzer;
+    std::priority_queue<std::pair<uint64_t, uint64_t>> trackedByHash; // (hash, line), largest hash on top
+    std::map<uint64_t, double> scaledHistogram; // scaled distance -> weighted sampled references
+    uint64_t accesses;
+    uint64_t sampledAccesses;
+    double coldSamples;
+    double sampleWeight; // weight of a new reference relative to the first ones
+};
+
+// Absolute miss-ratio error of an approximate curve against an exact one
+// over the same cache sizes.
+struct MrcError {
+    double meanAbsolute;
+    double maxAbsolute;
+};
+
+MrcError compareMissRatioCurves(const std::vector<std::pair<uint64_t, double>> &exact,
+                                const std::vector<std::pair<uint64_t, double>> &approximate);
@@ -0,0 +1,18 @@
+#include "sim_timing.hpp"
+#include <chrono>
+#include <thread>
+
+static thread_local uint64_t chargedLatency = 0;
+
+void chargeLatency(TimingModel model, uint64_t microseconds) {
+    if (model == TimingModel::Sleep)
+        std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+    else
+        chargedLatency += microseconds;
+}
+
+uint64_t consumeChargedLatency() {
+    uint64_t charged = chargedLatency;
+    chargedLatency = 0;
+    return charged;
+}
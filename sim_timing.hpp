@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+
+// How simulated latencies are paid. Sleep blocks the calling thread for the
+// latency, as a real device would. Accumulate only adds it to a per-thread
+// total that a scheduler collects, so one host thread can advance many
+// simulated cores, each on its own simulated clock.
+enum class TimingModel { Sleep, Accumulate };
+
+// Pays `microseconds` of simulated latency under the given model.
+void chargeLatency(TimingModel model, uint64_t microseconds);
+// Latency accumulated on the calling thread since the last call; resets it.
+uint64_t consumeChargedLatency();
@@ -0,0 +1,122 @@
+#include "simd_kernels.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_KERNELS_X86 1
+#endif
+
+static size_t countBitsScalar(const uint64_t *words, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        total += static_cast<size_t>(__builtin_popcountll(words[i]));
+    return total;
+}
+
+static bool anyBitSetScalar(const uint64_t *words, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (words[i])
+            return true;
+    }
+    return false;
+}
+
+#ifdef SIMD_KERNELS_X86
+
+// Same loop as the scalar version, but compiled to the POPCNT instruction
+// instead of a bit-twiddling sequence.
+__attribute__((target("popcnt")))
+static size_t countBitsPopcnt(const uint64_t *words, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        total += static_cast<size_t>(__builtin_popcountll(words[i]));
+    return total;
+}
+
+static bool anyBitSetSse2(const uint64_t *words, size_t count) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i acc = _mm_or_si128(
+            _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i)),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i + 2))),
+            _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i + 4)),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i + 6))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, zero)) != 0xFFFF)
+            return true;
+    }
+    return anyBitSetScalar(words + i, count - i);
+}
+
+// Nibble-lookup population count (Mula et al.): vpshufb counts the bits of
+// each 4-bit half, vpsadbw sums the per-byte counts into 64-bit lanes.
+__attribute__((target("avx2")))
+static size_t countBitsAvx2(const uint64_t *words, size_t count) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+        __m256i lo = _mm256_and_si256(v, lowMask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    size_t total = static_cast<size_t>(_mm256_extract_epi64(acc, 0)) + static_cast<size_t>(_mm256_extract_epi64(acc, 1)) +
+                   static_cast<size_t>(_mm256_extract_epi64(acc, 2)) + static_cast<size_t>(_mm256_extract_epi64(acc, 3));
+    return total + countBitsScalar(words + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static bool anyBitSetAvx2(const uint64_t *words, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i acc = _mm256_or_si256(
+            _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i + 4))),
+            _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i + 8)),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i + 12))));
+        if (!_mm256_testz_si256(acc, acc))
+            return true;
+    }
+    return anyBitSetScalar(words + i, count - i);
+}
+
+#endif
+
+struct SimdKernels {
+    size_t (*countBits)(const uint64_t *, size_t);
+    bool (*anyBitSet)(const uint64_t *, size_t);
+    const char *name;
+};
+
+static SimdKernels selectKernels() {
+#ifdef SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {countBitsAvx2, anyBitSetAvx2, "AVX2"};
+    if (__builtin_cpu_supports("popcnt"))
+        return {countBitsPopcnt, anyBitSetSse2, "SSE2+POPCNT"};
+    return {countBitsScalar, anyBitSetSse2, "SSE2"};
+#else
+    return {countBitsScalar, anyBitSetScalar, "scalar"};
+#endif
+}
+
+static const SimdKernels &kernels() {
+    static const SimdKernels selected = selectKernels();
+    return selected;
+}
+
+size_t simdCountBits(const uint64_t *words, size_t count) {
+    return kernels().countBits(words, count);
+}
+
+bool simdAnyBitSet(const uint64_t *words, size_t count) {
+    return kernels().anyBitSet(words, count);
+}
+
+std::string simdKernelName() {
+    return kernels().name;
+}
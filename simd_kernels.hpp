@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bulk kernels over packed 64-bit state words (see LineBitmap). The
+// implementation is chosen once at startup from the CPU's features: AVX2,
+// then SSE2 (with POPCNT when available), then portable scalar code.
+
+// Number of set bits in words[0, count).
+size_t simdCountBits(const uint64_t *words, size_t count);
+// True if any of words[0, count) is non-zero.
+bool simdAnyBitSet(const uint64_t *words, size_t count);
+// Name of the kernel set in use, e.g. "AVX2".
+std::string simdKernelName();
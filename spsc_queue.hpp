@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded single-producer/single-consumer ring buffer. Exactly one thread
+// may push and exactly one (other) thread may pop; neither side takes a
+// lock. Head and tail live on separate cache lines so the two threads do
+// not false-share, and each side caches the other's index to avoid reading
+// it on every operation.
+template <typename T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscQueue(size_t capacity) : mask(roundUp(capacity) - 1), slots(new T[mask + 1]) {}
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue& operator=(const SpscQueue &) = delete;
+
+    // Returns false if the queue is full.
+    bool tryPush(const T &item) {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        if (tail - producer.cachedOther > mask) {
+            producer.cachedOther = consumer.index.load(std::memory_order_acquire);
+            if (tail - producer.cachedOther > mask)
+                return false;
+        }
+        slots[tail & mask] = item;
+        producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the queue is empty.
+    bool tryPop(T &item) {
+        size_t head = consumer.index.load(std::memory_order_relaxed);
+        if (head == consumer.cachedOther) {
+            consumer.cachedOther = producer.index.load(std::memory_order_acquire);
+            if (head == consumer.cachedOther)
+                return false;
+        }
+        item = slots[head & mask];
+        consumer.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct alignas(64) Side {
+        std::atomic<size_t> index{0};
+        size_t cachedOther = 0; // last seen index of the other side
+    };
+
+    static size_t roundUp(size_t n) {
+        size_t size = 1;
+        while (size < n)
+            size <<= 1;
+        return size;
+    }
+
+    const size_t mask;
+    std::unique_ptr<T[]> slots;
+    Side producer; // tail: next slot to write
+    Side consumer; // head: next slot to read
+};
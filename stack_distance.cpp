@@ -0,0 +1,134 @@
+#include "stack_distance.hpp"
+#include <algorithm>
+
+// Smallest tree the analyzer starts with and regrows to.
+static const size_t MIN_TREE_SIZE = 1 << 16;
+
+FenwickTree::FenwickTree(size_t size) : tree(size + 1, 0) {}
+
+FenwickTree::FenwickTree(size_t size, size_t ones) : tree(size + 1, 0) {
+    // Each node adds its finished total into its parent.
+    for (size_t i = 1; i < tree.size(); ++i) {
+        if (i <= ones)
+            tree[i] += 1;
+        size_t parent = i + (i & (~i + 1));
+        if (parent < tree.size())
+            tree[parent] += tree[i];
+    }
+}
+
+void FenwickTree::add(size_t position, int64_t delta) {
+    for (; position < tree.size(); position += position & (~position + 1))
+        tree[position] += delta;
+}
+
+int64_t FenwickTree::prefixSum(size_t position) const {
+    int64_t sum = 0;
+    for (position = std::min(position, tree.size() - 1); position > 0; position -= position & (~position + 1))
+        sum += tree[position];
+    return sum;
+}
+
+size_t FenwickTree::size() const {
+    return tree.size() - 1;
+}
+
+StackDistanceAnalyzer::StackDistanceAnalyzer()
+    : marks(MIN_TREE_SIZE), now(0), accesses(0), coldMisses(0), histogram(1, 0) {}
+
+uint64_t StackDistanceAnalyzer::access(uint64_t line) {
+    if (now == marks.size())
+        compact();
+    ++now;
+    ++accesses;
+    uint64_t distance = COLD;
+    auto [it, inserted] = lastAccess.try_emplace(line, now);
+    if (inserted) {
+        coldMisses++;
+    } else {
+        uint64_t previous = it->second;
+        // Marks after `previous` are the distinct lines touched since, plus
+        // this line itself once it is re-marked.
+        distance = static_cast<uint64_t>(marks.prefixSum(now - 1) - marks.prefixSum(previous)) + 1;
+        marks.add(previous, -1);
+        it->second = now;
+        if (distance >= histogram.size())
+            histogram.resize(std::max<size_t>(distance + 1, histogram.size() * 2), 0);
+        histogram[distance]++;
+    }
+    marks.add(now, 1);
+    return distance;
+}
+
+void StackDistanceAnalyzer::forget(uint64_t line) {
+    auto it = lastAccess.find(line);
+    if (it == lastAccess.end())
+        return;
+    marks.add(it->second, -1);
+    lastAccess.erase(it);
+}
+
+void StackDistanceAnalyzer::compact() {
+    std::vector<std::pair<uint64_t, uint64_t>> live; // (time, line)
+    live.reserve(lastAccess.size());
+    for (const auto &[line, time] : lastAccess)
+        live.emplace_back(time, line);
+    std::sort(live.begin(), live.end());
+    // Live lines take times 1..k in access order, so exactly those are marked.
+    marks = FenwickTree(std::max(MIN_TREE_SIZE, live.size() * 2), live.size());
+    for (size_t i = 0; i < live.size(); ++i)
+        lastAccess[live[i].second] = i + 1;
+    now = live.size();
+}
+
+void StackDistanceAnalyzer::processTrace(const std::vector<TraceOp> &trace) {
+    for (const auto &op : trace) {
+        if (op.type != TraceOp::Type::Flush)
+            access(op.line);
+    }
+}
+
+uint64_t StackDistanceAnalyzer::getAccesses() const {
+    return accesses;
+}
+
+uint64_t StackDistanceAnalyzer::getColdMisses() const {
+    return coldMisses;
+}
+
+uint64_t StackDistanceAnalyzer::getDistinctLines() const {
+    return lastAccess.size();
+}
+
+const std::vector<uint64_t>& StackDistanceAnalyzer::getHistogram() const {
+    return histogram;
+}
+
+uint64_t StackDistanceAnalyzer::hits(uint64_t cacheLines) const {
+    uint64_t total = 0;
+    for (uint64_t d = 1; d < histogram.size() && d <= cacheLines; ++d)
+        total += histogram[d];
+    return total;
+}
+
+uint64_t StackDistanceAnalyzer::misses(uint64_t cacheLines) const {
+    return accesses - hits(cacheLines);
+}
+
+double StackDistanceAnalyzer::missRatio(uint64_t cacheLines) const {
+    return accesses ? static_cast<double>(misses(cacheLines)) / accesses : 0.0;
+}
+
+std::vector<std::pair<uint64_t, double>> StackDistanceAnalyzer::missRatioCurve(const std::vector<uint64_t> &cacheSizes) const {
+    std::vector<uint64_t> sorted(cacheSizes);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::pair<uint64_t, double>> curve;
+    uint64_t hitCount = 0;
+    uint64_t d = 1;
+    for (uint64_t size : sorted) {
+        for (; d < histogram.size() && d <= size; ++d)
+            hitCount += histogram[d];
+        curve.emplace_back(size, accesses ? static_cast<double>(accesses - hitCount) / accesses : 0.0);
+    }
+    return curve;
+}
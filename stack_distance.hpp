@@ -0,0 +1,71 @@
+#pragma once
+#include "trace.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Binary indexed tree of counts over positions 1..size.
+class FenwickTree {
+public:
+    explicit FenwickTree(size_t size = 0);
+    // Positions 1..ones hold 1 and the rest 0; built in O(size).
+    FenwickTree(size_t size, size_t ones);
+
+    void add(size_t position, int64_t delta);
+    // Sum of positions 1..position.
+    int64_t prefixSum(size_t position) const;
+    size_t size() const;
+
+private:
+    std::vector<int64_t> tree;
+};
+
+// Single-pass Mattson stack-distance analysis. Every access is stamped with
+// a logical time, and a Fenwick tree marks the time of each line's most
+// recent access; the stack distance of an access is the number of marks
+// after the line's previous access, i.e. the number of distinct lines
+// touched since then, found in O(log n). A fully associative LRU cache of
+// C lines hits exactly the accesses with distance <= C, so one pass yields
+// hit and miss counts for every cache size at once. CacheSimulator has no
+// tags or capacity (a line maps to index line % l1Size), so these curves
+// model a different cache and do not predict its l1Size sweeps.
+class StackDistanceAnalyzer {
+public:
+    static constexpr uint64_t COLD = 0; // distance of a line's first access
+
+    StackDistanceAnalyzer();
+
+    // Records an access and returns its stack distance (1 for an immediate
+    // re-access), or COLD.
+    uint64_t access(uint64_t line);
+    // Drops a line from the stack, as if it had never been accessed; later
+    // distances no longer count it. Used by sampled analyses that shrink
+    // their sample.
+    void forget(uint64_t line);
+    // Reads and writes are accesses; flushes write a line back without
+    // changing its recency, so they are skipped.
+    void processTrace(const std::vector<TraceOp> &trace);
+
+    uint64_t getAccesses() const;
+    uint64_t getColdMisses() const;
+    uint64_t getDistinctLines() const;
+    // histogram[d] = accesses with stack distance d (index 0 unused).
+    const std::vector<uint64_t>& getHistogram() const;
+    uint64_t hits(uint64_t cacheLines) const;
+    uint64_t misses(uint64_t cacheLines) const;
+    double missRatio(uint64_t cacheLines) const;
+    // (cache lines, miss ratio) for each size, from one scan of the histogram.
+    std::vector<std::pair<uint64_t, double>> missRatioCurve(const std::vector<uint64_t> &cacheSizes) const;
+
+private:
+    // Renumbers live marks to 1..k and regrows the tree once time runs out.
+    void compact();
+
+    FenwickTree marks;
+    std::unordered_map<uint64_t, uint64_t> lastAccess; // line -> time of its latest access
+    uint64_t now;
+    uint64_t accesses;
+    uint64_t coldMisses;
+    std::vector<uint64_t> histogram;
+};
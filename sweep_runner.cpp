@@ -0,0 +1,213 @@
+#include "sweep_runner.hpp"
+#include "result_cache.hpp"
+#include "trace_simulation.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+static const char *RESULT_COLUMNS[] = {"operations", "simulatedMicros", "flushes", "flushesElided", "wastedFlushes",
+                                       "lostPersists", "l2WriteBacks", "mediaWrites", "wpqFullStalls", "readChecksum", "wallMillis"};
+
+SweepSpec SweepSpec::fromJson(const nlohmann::ordered_json &ordered) {
+    json j = ordered;
+    SweepSpec spec;
+    json base = j.value("base", json("config.json"));
+    spec.base = base.is_string() ? Config::loadFromFile(base.get<std::string>()) : Config::fromJson(base);
+
+    json workload = j.value("workload", json::object());
+    spec.tracePath = workload.value("trace", std::string());
+    spec.syntheticCores = workload.value("cores", 16u);
+    spec.syntheticOpsPerCore = workload.value("opsPerCore", static_cast<size_t>(20000));
+    spec.syntheticLines = workload.value("lines", static_cast<uint64_t>(16384));
+    spec.syntheticSeed = workload.value("seed", 42u);
+
+    json fields = spec.base.toJson();
+    // Taken from the ordered document, so axes keep the order they are written in.
+    nlohmann::ordered_json axes = ordered.value("axes", nlohmann::ordered_json::object());
+    for (const auto &[field, values] : axes.items()) {
+        if (!fields.contains(field))
+            throw std::invalid_argument("Unknown Config field in sweep: " + field);
+        spec.axes.push_back({field, expandSweepValues(field, json(values))});
+    }
+    spec.workers = j.value("workers", static_cast<size_t>(0));
+    spec.output = j.value("output", std::string("sweep_results.csv"));
+    spec.cacheDir = j.value("cache", std::string(".sweep_cache"));
+    return spec;
+}
+
+SweepSpec SweepSpec::loadFromFile(const std::string &filename) {
+    std::ifstream inFile(filename);
+    if (!inFile)
+        throw std::invalid_argument("Cannot open sweep file: " + filename);
+    nlohmann::ordered_json j;
+    inFile >> j;
+    return fromJson(j);
+}
+
+json SweepSpec::workloadToJson() const {
+    if (!tracePath.empty())
+        return json{{"trace", tracePath}};
+    return json{{"cores", syntheticCores}, {"opsPerCore", syntheticOpsPerCore}, {"lines", syntheticLines},
+                {"seed", syntheticSeed}};
+}
+
+std::vector<TraceOp> SweepSpec::loadWorkload() const {
+    if (!tracePath.empty())
+        return loadTrace(tracePath);
+    return generateTrace(syntheticCores, syntheticOpsPerCore, syntheticLines, syntheticSeed);
+}
+
+std::vector<json> expandSweepValues(const std::string &field, const json &values) {
+    if (values.is_array()) {
+        if (values.empty())
+            throw std::invalid_argument("Sweep axis " + field + " has no values");
+        return values.get<std::vector<json>>();
+    }
+    if (!values.is_object() || !values.contains("from") || !values.contains("to"))
+        throw std::invalid_argument("Sweep axis " + field + " needs a list or a {from, to, step|factor} range");
+    json from = values["from"], to = values["to"];
+    bool integral = from.is_number_integer() && to.is_number_integer();
+    std::vector<json> expanded;
+    if (values.contains("factor")) {
+        double factor = values["factor"].get<double>();
+        if (factor <= 1.0 || from.get<double>() <= 0.0)
+            throw std::invalid_argument("Sweep axis " + field + " needs factor > 1 and from > 0");
+        for (double v = from.get<double>(); v <= to.get<double>(); v *= factor) {
+            json value = integral ? json(static_cast<int64_t>(v)) : json(v);
+            // Truncating a non-integer factor can repeat a value (1, 1.5 -> 1, 1).
+            if (expanded.empty() || expanded.back() != value)
+                expanded.push_back(value);
+        }
+    } else {
+        json step = values.value("step", json(1));
+        if (step.get<double>() <= 0.0)
+            throw std::invalid_argument("Sweep axis " + field + " needs step > 0");
+        integral = integral && step.is_number_integer();
+        if (integral) {
+            for (int64_t v = from.get<int64_t>(); v <= to.get<int64_t>(); v += step.get<int64_t>())
+                expanded.push_back(v);
+        } else {
+            size_t count = static_cast<size_t>((to.get<double>() - from.get<double>()) / step.get<double>() + 1e-9) + 1;
+            for (size_t i = 0; i < count; ++i)
+                expanded.push_back(from.get<double>() + i * step.get<double>());
+        }
+    }
+    if (expanded.empty())
+        throw std::invalid_argument("Sweep axis " + field + " range is empty");
+    return expanded;
+}
+
+SweepRunner::SweepRunner(const SweepSpec &spec) : spec(spec) {
+    // Odometer over the axes; the last axis varies fastest.
+    std::vector<size_t> position(spec.axes.size(), 0);
+    json baseJson = spec.base.toJson();
+    for (;;) {
+        SweepPoint point{json::object(), spec.base};
+        json merged = baseJson;
+        for (size_t a = 0; a < spec.axes.size(); ++a) {
+            const json &value = spec.axes[a].values[position[a]];
+            point.settings[spec.axes[a].field] = value;
+            merged[spec.axes[a].field] = value;
+        }
+        point.config = Config::fromJson(merged);
+        points.push_back(point);
+        size_t a = spec.axes.size();
+        while (a > 0 && ++position[a - 1] == spec.axes[a - 1].values.size())
+            position[--a] = 0;
+        if (a == 0)
+            break;
+    }
+}
+
+const std::vector<SweepPoint>& SweepRunner::getPoints() const {
+    return points;
+}
+
+std::vector<SweepRow> SweepRunner::run() {
+    std::vector<TraceOp> trace = spec.loadWorkload();
+    // The content hash catches edited trace files and generator changes alike.
+    json workload = spec.workloadToJson();
+    workload["contentHash"] = hashTrace(trace);
+    std::unique_ptr<ResultCache> cache;
+    if (!spec.cacheDir.empty())
+        cache = std::make_unique<ResultCache>(spec.cacheDir);
+
+    std::vector<SweepRow> rows;
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < points.size(); ++i) {
+        RunResult cached{};
+        bool hit = cache && cache->lookup(points[i].config, workload, cached);
+        rows.push_back({points[i], JobOutcome{hit, 0, cached}, hit});
+        if (!hit)
+            pending.push_back(i);
+    }
+    if (pending.empty())
+        return rows;
+
+    size_t workers = spec.workers > 0 ? spec.workers : std::max(1u, std::thread::hardware_concurrency());
+    ProcessCoordinator coordinator(workers);
+    coordinator.shareTrace(trace);
+    std::vector<Config> configs;
+    for (size_t i : pending)
+        configs.push_back(points[i].config);
+    auto outcomes = coordinator.runConfigs(configs);
+    for (size_t k = 0; k < pending.size(); ++k) {
+        rows[pending[k]].outcome = outcomes[k];
+        if (cache && outcomes[k].completed)
+            cache->store(points[pending[k]].config, workload, outcomes[k].result);
+    }
+    return rows;
+}
+
+static std::string csvField(const json &value) {
+    if (!value.is_string())
+        return value.dump();
+    std::string text = value.get<std::string>();
+    if (text.find_first_of(",\"\n") == std::string::npos)
+        return text;
+    std::string quoted = "\"";
+    for (char c : text)
+        quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+    return quoted + "\"";
+}
+
+void SweepRunner::writeCsv(std::ostream &out, const std::vector<SweepRow> &rows) const {
+    for (const auto &axis : spec.axes)
+        out << axis.field << ',';
+    out << "status";
+    for (const char *column : RESULT_COLUMNS)
+        out << ',' << column;
+    out << '\n';
+    for (const auto &row : rows) {
+        for (const auto &axis : spec.axes)
+            out << csvField(row.point.settings[axis.field]) << ',';
+        out << (row.cached ? "cached" : row.outcome.completed ? "ok" : "failed");
+        json result = runResultToJson(row.outcome.result);
+        for (const char *column : RESULT_COLUMNS)
+            out << ',' << (row.outcome.completed ? result[column].dump() : std::string());
+        out << '\n';
+    }
+}
+
+void SweepRunner::writeResults(const std::string &path, const std::vector<SweepRow> &rows) const {
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("Cannot write sweep results: " + path);
+    bool asJson = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (!asJson) {
+        writeCsv(out, rows);
+        return;
+    }
+    json results = json::array();
+    for (const auto &row : rows) {
+        json entry = {{"settings", row.point.settings}, {"config", row.point.config.toJson()},
+                      {"workload", spec.workloadToJson()}, {"status", row.cached ? "cached" : row.outcome.completed ? "ok" : "failed"}};
+        if (row.outcome.completed)
+            entry["result"] = runResultToJson(row.outcome.result);
+        else
+            entry["signal"] = row.outcome.signal;
+        results.push_back(entry);
+    }
+    out << results.dump(2) << '\n';
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "config.hpp"
+#include "process_coordinator.hpp"
+#include "trace.hpp"
+#include <string>
+#include <vector>
+
+// One swept Config field and the values it takes.
+struct SweepAxis {
+    std::string field;
+    std::vector<json> values;
+};
+
+// A parameter sweep read from JSON:
+//   {
+//     "base": "config.json",                  // Config every point starts from
+//     "workload": {"trace": "run.trace"}      // or {"cores", "opsPerCore", "lines", "seed"}
+//     "axes": {                                // any Config field
+//       "l1Size": [1024, 4096],                // explicit list
+//       "flushLatency": {"from": 50, "to": 200, "step": 50},
+//       "nvmWpqEntries": {"from": 4, "to": 64, "factor": 2}
+//     },
+//     "workers": 0,                            // worker processes, 0 = one per host CPU
+//     "output": "sweep_results.csv",           // .csv or .json
+//     "cache": ".sweep_cache"                  // result memo directory, "" disables
+//   }
+// The sweep runs the cross product of the axes, skipping points whose
+// result is already in the cache (see ResultCache). Axes keep the order they
+// are written in, which is also the order of their output columns; the last
+// varies fastest. A factor range on an integral axis truncates each value and
+// drops repeats.
+struct SweepSpec {
+    Config base;
+    std::string tracePath; // empty: synthetic trace
+    uint32_t syntheticCores;
+    size_t syntheticOpsPerCore;
+    uint64_t syntheticLines;
+    uint32_t syntheticSeed;
+    std::vector<SweepAxis> axes;
+    size_t workers;
+    std::string output;
+    std::string cacheDir;
+
+    // Throws std::invalid_argument for unknown fields or malformed ranges.
+    static SweepSpec fromJson(const nlohmann::ordered_json &j);
+    static SweepSpec loadFromFile(const std::string &filename);
+    // The workload as a JSON object, e.g. for labelling results.
+    json workloadToJson() const;
+    std::vector<TraceOp> loadWorkload() const;
+};
+
+// Expands an axis value: a list, {"from", "to", "step"} or
+// {"from", "to", "factor"}; ranges include "to" when it is reached exactly.
+std::vector<json> expandSweepValues(const std::string &field, const json &values);
+
+struct SweepPoint {
+    json settings; // the axis values of this point
+    Config config;
+};
+
+struct SweepRow {
+    SweepPoint point;
+    JobOutcome outcome;
+    bool cached; // result came from the cache rather than a new run
+};
+
+// Runs a sweep's points in parallel worker processes (see
+// ProcessCoordinator), at most one per host CPU unless the spec says
+// otherwise. Points found in the result cache are not run again, and new
+// results are added to it.
+class SweepRunner {
+public:
+    explicit SweepRunner(const SweepSpec &spec);
+
+    const std::vector<SweepPoint>& getPoints() const;
+    std::vector<SweepRow> run();
+    // Writes one row per point; the format follows the extension of `path`
+    // (.json for a JSON array, CSV otherwise).
+    void writeResults(const std::string &path, const std::vector<SweepRow> &rows) const;
+
+private:
+    void writeCsv(std::ostream &out, const std::vector<SweepRow> &rows) const;
+
+    SweepSpec spec;
+    std::vector<SweepPoint> points;
+};
@@ -0,0 +1,83 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<TraceOp> loadTrace(const std::string &path) {
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("Cannot open trace: " + path);
+    std::vector<TraceOp> ops;
+    std::string text;
+    size_t lineNumber = 0;
+    while (std::getline(in, text)) {
+        ++lineNumber;
+        std::istringstream fields(text);
+        char kind;
+        if (!(fields >> kind) || kind == '#')
+            continue;
+        TraceOp op{TraceOp::Type::Write, 0, 0, 0};
+        bool ok = static_cast<bool>(fields >> op.core >> op.line);
+        if (kind == 'W')
+            ok = ok && static_cast<bool>(fields >> op.value);
+        else if (kind == 'F')
+            op.type = TraceOp::Type::Flush;
+        else if (kind == 'R')
+            op.type = TraceOp::Type::Read;
+        else
+            ok = false;
+        if (!ok)
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": malformed trace line");
+        ops.push_back(op);
+    }
+    return ops;
+}
+
+void saveTrace(const std::string &path, const std::vector<TraceOp> &ops) {
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("Cannot write trace: " + path);
+    for (const auto &op : ops) {
+        switch (op.type) {
+        case TraceOp::Type::Write:
+            out << "W " << op.core << ' ' << op.line << ' ' << op.value << '\n';
+            break;
+        case TraceOp::Type::Flush:
+            out << "F " << op.core << ' ' << op.line << '\n';
+            break;
+        case TraceOp::Type::Read:
+            out << "R " << op.core << ' ' << op.line << '\n';
+            break;
+        }
+    }
+}
+
+std::vector<TraceOp> generateTrace(uint32_t numCores, size_t opsPerCore, uint64_t numLines, uint32_t seed) {
+    const uint64_t recordLines = 4;
+    std::mt19937_64 generator(seed);
+    uint64_t region = std::max<uint64_t>(numLines / std::max(numCores, 1u), recordLines);
+    std::uniform_int_distribution<uint64_t> anyLine(0, numLines - 1);
+    std::vector<std::vector<TraceOp>> perCore(numCores);
+    for (uint32_t core = 0; core < numCores; ++core) {
+        auto &ops = perCore[core];
+        uint64_t base = (core * region) % numLines;
+        for (uint64_t record = 0; ops.size() < opsPerCore; ++record) {
+            uint64_t first = base + (record * recordLines) % region;
+            for (uint64_t i = 0; i < recordLines; ++i)
+                ops.push_back({TraceOp::Type::Write, core, (first + i) % numLines, static_cast<int>(record * 100 + i)});
+            for (uint64_t i = 0; i < recordLines; ++i)
+                ops.push_back({TraceOp::Type::Flush, core, (first + i) % numLines, 0});
+            ops.push_back({TraceOp::Type::Read, core, anyLine(generator), 0});
+        }
+        ops.resize(opsPerCore);
+    }
+    std::vector<TraceOp> trace;
+    trace.reserve(static_cast<size_t>(numCores) * opsPerCore);
+    for (size_t i = 0; i < opsPerCore; ++i) {
+        for (uint32_t core = 0; core < numCores; ++core)
+            trace.push_back(perCore[core][i]);
+    }
+    return trace;
+}
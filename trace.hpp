@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One memory operation of a simulated core, as recorded in a trace.
+struct TraceOp {
+    enum class Type : uint8_t { Write, Flush, Read };
+    Type type;
+    uint32_t core;
+    uint64_t line;
+    int value; // written value; unused for Flush and Read
+};
+
+// Text trace, one operation per line:
+//   W <core> <line> <value>
+//   F <core> <line>
+//   R <core> <line>
+// Blank lines and lines starting with '#' are ignored. Throws
+// std::runtime_error if the file cannot be read or a line is malformed.
+std::vector<TraceOp> loadTrace(const std::string &path);
+void saveTrace(const std::string &path, const std::vector<TraceOp> &ops);
+
+// Synthetic trace: cores interleaved round-robin, each writing a record of
+// a few lines in its own region, flushing it and reading back lines that
+// other cores wrote. Same seed, same trace.
+std::vector<TraceOp> generateTrace(uint32_t numCores, size_t opsPerCore, uint64_t numLines, uint32_t seed);
@@ -0,0 +1,142 @@
+#include "trace_simulation.hpp"
+#include "cache_simulator.hpp"
+#include "memory_controller.hpp"
+#include "multi_level_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+RunResult runTraceSimulation(const Config &cfg, const TraceOp *ops, size_t count, uint64_t firstIndex, uint64_t endIndex) {
+    auto start = std::chrono::steady_clock::now();
+    MemoryController nvm(cfg.nvmWpqEntries, cfg.nvmBandwidthMBps,
+                         cfg.nvmChannels, cfg.nvmDimmsPerChannel, cfg.nvmInterleaveBytes);
+    L2Cache l2Cache(cfg.l2Size);
+    l2Cache.setMemoryController(&nvm);
+    l2Cache.setTimingModel(TimingModel::Accumulate);
+    PersistenceDomain domain = persistenceDomainFromString(cfg.persistenceDomain);
+    l2Cache.setPersistenceDomain(domain);
+    size_t numCores = static_cast<size_t>(std::max(cfg.numCores, 1));
+    if (numCores > MAX_RESULT_CORES)
+        throw std::invalid_argument("Trace replay supports at most " + std::to_string(MAX_RESULT_CORES) + " cores");
+    std::vector<std::unique_ptr<CacheSimulator>> l1Caches;
+    for (size_t core = 0; core < numCores; ++core) {
+        auto cache = std::make_unique<CacheSimulator>(cfg.l1Size);
+        cache->setFlushLatency(cfg.flushLatency);
+        cache->setCleanLatency(cfg.cleanLatency);
+        cache->setReadLatency(cfg.readLatency);
+        cache->setMemoryController(&nvm);
+        cache->setPersistenceDomain(domain);
+        cache->setFlushCoalescingWindow(cfg.flushCoalescingWindow);
+        cache->setTimingModel(TimingModel::Accumulate);
+        l1Caches.push_back(std::move(cache));
+    }
+
+    RunResult result{};
+    std::vector<uint64_t> coreTime(numCores, 0);
+    // The controller is shared, so it runs on the latest time any core has
+    // reached; a per-issuer clock would jump back and forth between cores.
+    uint64_t frontier = 0;
+    nvm.setClock([&]() { return static_cast<double>(frontier); });
+    for (auto &cache : l1Caches)
+        cache->setCoalescingClock([&]() { return frontier; });
+    // Trace line of each L1 line's latest flush request, which picks its L2 line.
+    std::vector<std::unordered_map<size_t, uint64_t>> flushedTraceLine(numCores);
+    auto writeBack = [&](size_t core, size_t line, int value) {
+        l2Cache.updateLineFromL1(flushedTraceLine[core][line] % cfg.l2Size, value, false);
+        result.l2WriteBacks++;
+    };
+    // Under ADR a flush deferred by the coalescing window is issued during a
+    // later operation or fence, so write-backs are taken when a line persists.
+    // Under eADR stores persist as they happen and flushes are elided on the
+    // spot, so there the flush's own result counts them.
+    if (domain == PersistenceDomain::ADR) {
+        for (size_t core = 0; core < numCores; ++core)
+            l1Caches[core]->setPersistObserver([&, core](size_t line, int value) { writeBack(core, line, value); });
+    }
+    consumeChargedLatency();
+    for (size_t i = 0; i < count; ++i) {
+        const TraceOp &op = ops[i];
+        size_t line = op.line % cfg.l1Size;
+        if (line < firstIndex || line >= endIndex)
+            continue;
+        size_t core = op.core % numCores;
+        CacheSimulator &l1Cache = *l1Caches[core];
+        switch (op.type) {
+        case TraceOp::Type::Write:
+            l1Cache.writeLine(line, op.value);
+            break;
+        case TraceOp::Type::Flush:
+            flushedTraceLine[core][line] = op.line;
+            if ((cfg.skipPredictor ? l1Cache.flushLine(line) : l1Cache.flushLine(line, true))
+                && domain == PersistenceDomain::EADR)
+                writeBack(core, line, l1Cache.peekLine(line));
+            break;
+        case TraceOp::Type::Read:
+            result.readChecksum += static_cast<unsigned>(l1Cache.readLine(line));
+            break;
+        }
+        coreTime[core] += consumeChargedLatency();
+        frontier = std::max(frontier, coreTime[core]);
+        result.operations++;
+    }
+    // Issue the flushes still waiting in a coalescing window.
+    for (size_t core = 0; core < numCores; ++core) {
+        l1Caches[core]->memoryFence();
+        coreTime[core] += consumeChargedLatency();
+        frontier = std::max(frontier, coreTime[core]);
+    }
+
+    for (auto &cache : l1Caches) {
+        auto &stats = cache->getStats();
+        result.flushes += stats.flushCount;
+        result.flushesElided += stats.flushesElided;
+        result.wastedFlushes += stats.wastedFlushes;
+        result.lostPersists += stats.mispredictedSkips;
+    }
+    result.simulatedMicros = *std::max_element(coreTime.begin(), coreTime.end());
+    result.cores = static_cast<uint32_t>(numCores);
+    std::copy(coreTime.begin(), coreTime.end(), result.coreMicros);
+    result.mediaWrites = nvm.getStats().mediaWrites;
+    result.wpqFullStalls = nvm.getStats().wpqFullStalls;
+    result.wallMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+json runResultToJson(const RunResult &result) {
+    return json{
+        {"operations", result.operations},
+        {"simulatedMicros", result.simulatedMicros},
+        {"flushes", result.flushes},
+        {"flushesElided", result.flushesElided},
+        {"wastedFlushes", result.wastedFlushes},
+        {"lostPersists", result.lostPersists},
+        {"l2WriteBacks", result.l2WriteBacks},
+        {"mediaWrites", result.mediaWrites},
+        {"wpqFullStalls", result.wpqFullStalls},
+        {"readChecksum", result.readChecksum},
+        {"wallMillis", result.wallMillis},
+        {"coreMicros", std::vector<uint64_t>(result.coreMicros, result.coreMicros + result.cores)},
+    };
+}
+
+RunResult runResultFromJson(const json &j) {
+    RunResult result{};
+    result.operations = j.at("operations").get<uint64_t>();
+    result.simulatedMicros = j.at("simulatedMicros").get<uint64_t>();
+    result.flushes = j.at("flushes").get<uint64_t>();
+    result.flushesElided = j.at("flushesElided").get<uint64_t>();
+    result.wastedFlushes = j.at("wastedFlushes").get<uint64_t>();
+    result.lostPersists = j.at("lostPersists").get<uint64_t>();
+    result.l2WriteBacks = j.at("l2WriteBacks").get<uint64_t>();
+    result.mediaWrites = j.at("mediaWrites").get<uint64_t>();
+    result.wpqFullStalls = j.at("wpqFullStalls").get<uint64_t>();
+    result.readChecksum = j.at("readChecksum").get<uint64_t>();
+    result.wallMillis = j.at("wallMillis").get<double>();
+    auto coreMicros = j.at("coreMicros").get<std::vector<uint64_t>>();
+    result.cores = static_cast<uint32_t>(std::min(coreMicros.size(), MAX_RESULT_CORES));
+    std::copy_n(coreMicros.begin(), result.cores, result.coreMicros);
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "config.hpp"
+#include "trace.hpp"
+#include <cstdint>
+
+// Simulated cores whose times a RunResult can carry.
+constexpr size_t MAX_RESULT_CORES = 256;
+
+// Outcome of one trace replay. Plain data so it can be placed in shared
+// memory and written to result files as-is.
+struct RunResult {
+    uint64_t operations;
+    uint64_t simulatedMicros; // longest per-core simulated time
+    uint64_t flushes;
+    uint64_t flushesElided;
+    uint64_t wastedFlushes; // with cfg.skipPredictor: flushes predicted necessary for persisted lines
+    uint64_t lostPersists;  // with cfg.skipPredictor: dirty lines whose flush was predicted redundant
+    uint64_t l2WriteBacks;
+    uint64_t mediaWrites;
+    uint64_t wpqFullStalls;
+    uint64_t readChecksum;
+    double wallMillis;
+    uint32_t cores; // entries of coreMicros in use
+    uint64_t coreMicros[MAX_RESULT_CORES]; // simulated time of each core
+};
+
+// Replays `count` trace operations on the hierarchy described by `cfg`: one
+// L1 per simulated core (trace cores are folded onto cfg.numCores, at most
+// MAX_RESULT_CORES, else std::invalid_argument is thrown), a shared
+// L2 and the NVM memory controller. Caches run under TimingModel::Accumulate
+// and the controller drains on the latest simulated time any core has
+// reached, so the replay never sleeps. Only operations whose L1 index (line % l1Size) falls
+// in [firstIndex, endIndex) are replayed; lines that alias in the L1 stay
+// together, so a trace split this way into address shards keeps every
+// line's history in one shard.
+RunResult runTraceSimulation(const Config &cfg, const TraceOp *ops, size_t count,
+                             uint64_t firstIndex = 0, uint64_t endIndex = UINT64_MAX);
+
+json runResultToJson(const RunResult &result);
+// Throws json exceptions if a field is missing.
+RunResult runResultFromJson(const json &j);
@@ -4,6 +4,10 @@
 #include <chrono>
 #include <thread>
 #include <memory>
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <stdexcept>
 
 #include "cache_simulator.hpp"
 #include "multi_level_cache.hpp"
@@ -11,21 +15,48 @@
 #include "config.hpp"
 #include "ReadableFlexibleLogger.hpp"
 #include "vectorized_hash_table.hpp"
+#include "crash_simulator.hpp"
+#include "event_engine.hpp"
+#include "pdes_simulation.hpp"
+#include "sharded_simulator.hpp"
+#include "trace.hpp"
+#include "process_coordinator.hpp"
+#include "sweep_runner.hpp"
+#include "stack_distance.hpp"
+#include "shards_sampler.hpp"
 
 // Forward declarations for modes.
 void runBenchmark();
 void runMulticoreSimulation();
 void runSkipcacheAdvanced();
 void runVectorizedHashTableDemo();
+void runCrashConsistencyCheck();
+void runCoroutineCores();
+void runParallelEventSimulation();
+void runShardedReplay(const std::string &tracePath);
+void runScaleOut(const std::string &tracePath);
+void runSweep(const std::string &sweepPath);
+void runMissRatioCurve(const std::string &tracePath);
+void runSampledMissRatioCurve(const std::string &tracePath, double rate, size_t maxLines, bool compareExact);
 
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <mode>\n";
+        std::cout << "Usage: " << argv[0] << " <mode> [trace-file | sweep-file]\n"
+                  << "       " << argv[0] << " shards [trace-file] [sampling-rate] [max-lines] [--exact]\n";
         std::cout << "Available modes:\n"
                   << "  benchmark   - Run the original benchmark simulation.\n"
                   << "  multi       - Run the multi-core simulation.\n"
                   << "  skipcache   - Run the extended skipcache simulation.\n"
-                  << "  vectorized  - Run the vectorized hash table demo.\n";
+                  << "  vectorized  - Run the vectorized hash table demo.\n"
+                  << "  crash       - Run the crash-injection recovery checker.\n"
+                  << "  coro        - Run coroutine-based simulated cores on the event engine.\n"
+                  << "  pdes        - Run the partitioned parallel event simulation.\n"
+                  << "  sharded     - Replay a trace (or a synthetic one) on the owner-computes sharded simulator.\n"
+                  << "  scaleout    - Replay a trace under several configs and address shards in worker processes.\n"
+                  << "  sweep       - Run a parameter sweep (default sweep.json) and write one row per point.\n"
+                  << "  mrc         - Compute an LRU miss-ratio curve for a trace in one stack-distance pass.\n"
+                  << "  shards      - Approximate the miss-ratio curve by SHARDS sampling at a fixed rate and a fixed\n"
+                  << "                size (0 skips either); --exact also runs the exact pass and reports the error.\n";
         return 1;
     }
 
@@ -39,6 +70,25 @@ int main(int argc, char *argv[]) {
         runSkipcacheAdvanced();
     } else if (mode == "vectorized") {
         runVectorizedHashTableDemo();
+    } else if (mode == "crash") {
+        runCrashConsistencyCheck();
+    } else if (mode == "coro") {
+        runCoroutineCores();
+    } else if (mode == "pdes") {
+        runParallelEventSimulation();
+    } else if (mode == "sharded") {
+        runShardedReplay(argc > 2 ? argv[2] : "");
+    } else if (mode == "scaleout") {
+        runScaleOut(argc > 2 ? argv[2] : "");
+    } else if (mode == "sweep") {
+        runSweep(argc > 2 ? argv[2] : "sweep.json");
+    } else if (mode == "mrc") {
+        runMissRatioCurve(argc > 2 ? argv[2] : "");
+    } else if (mode == "shards") {
+        std::vector<std::string> args(argv + 2, argv + argc);
+        bool compareExact = std::erase(args, std::string("--exact")) > 0;
+        runSampledMissRatioCurve(args.size() > 0 ? args[0] : "", args.size() > 1 ? std::stod(args[1]) : 0.01,
+                                 args.size() > 2 ? std::stoul(args[2]) : 8192, compareExact);
     } else {
         std::cout << "Unknown mode: " << mode << std::endl;
         return 1;
@@ -86,3 +136,410 @@ void runVectorizedHashTableDemo() {
     vht.print();
     std::cout << "Vectorized hash table demo complete.\n";
 }
+
+static void printCrashReport(const std::string &name, const CrashReport &report) {
+    std::cout << name << ": " << report.crashPointsChecked << " crash points, "
+              << report.violations << " violations\n";
+    for (const auto &failure : report.failures)
+        std::cout << "  " << failure << "\n";
+}
+
+void runCrashConsistencyCheck() {
+    std::cout << "Running crash-injection recovery checker...\n";
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int counterIterations = 10000;
+    const size_t logEntries = 200;
+    for (PersistenceDomain domain : {PersistenceDomain::ADR, PersistenceDomain::EADR}) {
+        std::string domainName = domain == PersistenceDomain::ADR ? "ADR" : "eADR";
+        for (bool useSkip : {false, true}) {
+            std::string suffix = " [" + domainName + (useSkip ? ", skip]" : ", no skip]");
+
+            CrashSimulator counterSim(1, domain);
+            counterSim.record(persistentCounterWorkload(0, counterIterations, useSkip));
+            printCrashReport("PersistentCounter exhaustive" + suffix,
+                             counterSim.checkExhaustive(persistentCounterCheck(0, counterIterations), numThreads));
+
+            CrashSimulator logSim(logEntries * LOG_ENTRY_LINES, domain);
+            logSim.record(validityLogWorkload(logEntries, useSkip));
+            printCrashReport("Validity log exhaustive" + suffix,
+                             logSim.checkExhaustive(validityLogCheck(logEntries), numThreads));
+            printCrashReport("Validity log random" + suffix,
+                             logSim.checkRandom(100000, 42, validityLogCheck(logEntries), numThreads));
+        }
+    }
+    std::cout << "Crash-injection recovery checker complete.\n";
+}
+
+// One simulated core appending to its own persistent log: write an entry,
+// post a flush per line, fence, then read the entry's first line back.
+static CoreProgram logAppendCore(EventEngine &engine, CacheSimulator &cache, size_t firstLine, size_t entryLines,
+                                 int entries, size_t &inFlight, size_t &peakInFlight) {
+    AsyncCache async(engine, cache);
+    for (int entry = 0; entry < entries; ++entry) {
+        for (size_t i = 0; i < entryLines; ++i) {
+            async.writeLine(firstLine + i, entry * 100 + static_cast<int>(i) + 1);
+            co_await async.flushLine(firstLine + i);
+        }
+        size_t posted = async.getFlushesInFlight();
+        inFlight += posted;
+        peakInFlight = std::max(peakInFlight, inFlight);
+        co_await async.memoryFence();
+        inFlight -= posted;
+        co_await async.readLine(firstLine);
+    }
+}
+
+void runCoroutineCores() {
+    const size_t numCores = 100000;
+    const size_t entryLines = 8;
+    const int entries = 4;
+    std::cout << "Running " << numCores << " coroutine cores on one host thread...\n";
+    CacheSimulator cache(numCores * entryLines);
+    cache.setTimingModel(TimingModel::Accumulate);
+    EventEngine engine;
+    size_t inFlight = 0, peakInFlight = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t core = 0; core < numCores; ++core)
+        engine.spawn(logAppendCore(engine, cache, core * entryLines, entryLines, entries, inFlight, peakInFlight));
+    engine.run();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Simulated time: " << engine.now() << " us, events: " << engine.getEventsProcessed()
+              << ", peak suspended operations: " << engine.getPeakPendingEvents()
+              << ", peak flushes in flight: " << peakInFlight << "\n";
+    std::cout << "Flushes: " << cache.getStats().flushCount << ", fences: " << cache.getStats().fenceCount
+              << ", wall time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+}
+
+// A core that persists a small record each round, publishes it to the shared
+// L2 and folds a value written by another core into its next record, so the
+// result depends on the global order of L2 accesses.
+static CoreProgram sharedL2Core(EventEngine &engine, CacheSimulator &l1Cache, L2Port &port, size_t coreId,
+                                size_t l2Lines, int rounds) {
+    AsyncCache async(engine, l1Cache);
+    unsigned carried = static_cast<unsigned>(coreId);
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < l1Cache.getNumLines(); ++i) {
+            async.writeLine(i, static_cast<int>(carried + i));
+            co_await async.flushLine(i);
+        }
+        co_await async.memoryFence();
+        port.writeBack(coreId, (coreId * 7 + round) % l2Lines, static_cast<int>(carried & 0x7fffffff));
+        int shared = co_await port.read(coreId, (coreId * 13 + round * 5) % l2Lines);
+        carried = carried * 31 + static_cast<unsigned>(shared);
+        co_await engine.delay(coreId % 7);
+    }
+}
+
+void runParallelEventSimulation() {
+    const size_t numCores = 512;
+    const size_t l1Lines = 8;
+    const size_t l2Lines = 1024;
+    const int rounds = 20;
+    const uint64_t l2Latency = 20; // lookahead: no core can affect another sooner
+    std::vector<size_t> partitionCounts = {1, 2, 4, std::max<size_t>(std::thread::hardware_concurrency(), 1)};
+    std::sort(partitionCounts.begin(), partitionCounts.end());
+    partitionCounts.erase(std::unique(partitionCounts.begin(), partitionCounts.end()), partitionCounts.end());
+    std::cout << "PDES: " << numCores << " cores, L2 lookahead " << l2Latency << " us\n";
+    // Every partitioning must reproduce the sequential (1-partition) run.
+    uint64_t referenceChecksum = 0, referenceTime = 0;
+    size_t mismatches = 0;
+    for (size_t partitions : partitionCounts) {
+        L2Cache l2Cache(l2Lines);
+        l2Cache.setTimingModel(TimingModel::Accumulate);
+        PdesSimulation pdes(partitions, l2Latency, l2Cache);
+        std::vector<std::unique_ptr<CacheSimulator>> l1Caches;
+        for (size_t core = 0; core < numCores; ++core) {
+            l1Caches.push_back(std::make_unique<CacheSimulator>(l1Lines));
+            l1Caches.back()->setTimingModel(TimingModel::Accumulate);
+            size_t partition = core % pdes.getNumPartitions();
+            pdes.getEngine(partition).spawn(sharedL2Core(pdes.getEngine(partition), *l1Caches.back(),
+                                                         pdes.getPort(partition), core, l2Lines, rounds));
+        }
+        auto start = std::chrono::steady_clock::now();
+        pdes.run();
+        auto end = std::chrono::steady_clock::now();
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < l2Lines; ++i)
+            checksum = checksum * 1099511628211ull + static_cast<unsigned>(l2Cache.getLines()[i].data);
+        if (partitions == 1) {
+            referenceChecksum = checksum;
+            referenceTime = pdes.now();
+        }
+        bool matches = checksum == referenceChecksum && pdes.now() == referenceTime;
+        if (!matches)
+            mismatches++;
+        auto &stats = pdes.getStats();
+        std::cout << "  " << partitions << " partition(s): simulated " << pdes.now() << " us, " << stats.windows
+                  << " windows, " << stats.messages << " L2 messages, " << stats.eventsProcessed << " events, L2 checksum "
+                  << std::hex << checksum << std::dec << (matches ? "" : " DIFFERS from 1 partition") << ", wall "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+    }
+    std::cout << mismatches << " of " << partitionCounts.size() << " partitionings differ from the sequential run\n";
+}
+
+// Replays the trace on one cache pair shared by every replay thread, the
+// locking baseline for the sharded replay.
+static void replayLocked(const std::vector<TraceOp> &trace, size_t numLines, size_t numProducers,
+                         std::vector<int> &finalLines) {
+    CacheSimulator l1Cache(numLines);
+    L2Cache l2Cache(numLines);
+    l1Cache.setTimingModel(TimingModel::Accumulate);
+    l2Cache.setTimingModel(TimingModel::Accumulate);
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < numProducers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (const auto &op : trace) {
+                if (op.core % numProducers != p)
+                    continue;
+                if (op.type == TraceOp::Type::Write)
+                    l1Cache.writeLine(op.line, op.value);
+                else if (op.type == TraceOp::Type::Flush && l1Cache.flushLine(op.line, true))
+                    l2Cache.updateLineFromL1(op.line, l1Cache.peekLine(op.line), false);
+                else if (op.type == TraceOp::Type::Read)
+                    l1Cache.readLine(op.line);
+            }
+            consumeChargedLatency();
+        });
+    }
+    for (auto &t : producers)
+        t.join();
+    for (size_t i = 0; i < numLines; ++i)
+        finalLines[i] = l2Cache.getLines()[i].data;
+}
+
+void runShardedReplay(const std::string &tracePath) {
+    size_t numLines = 1 << 16;
+    std::vector<TraceOp> trace;
+    if (tracePath.empty()) {
+        trace = generateTrace(64, 20000, numLines, 42);
+    } else {
+        trace = loadTrace(tracePath);
+        uint64_t highest = 0;
+        for (const auto &op : trace)
+            highest = std::max(highest, op.line);
+        numLines = highest + 1;
+    }
+    size_t numProducers = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    std::cout << "Replaying " << trace.size() << " operations over " << numLines << " lines with "
+              << numProducers << " replay threads\n";
+
+    std::vector<int> expected(numLines);
+    auto start = std::chrono::steady_clock::now();
+    replayLocked(trace, numLines, numProducers, expected);
+    auto end = std::chrono::steady_clock::now();
+    double lockedMs = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "  locked shared caches: " << lockedMs << " ms\n";
+
+    std::vector<size_t> shardCounts = {1, 2, 4, std::max<size_t>(std::thread::hardware_concurrency(), 1)};
+    std::sort(shardCounts.begin(), shardCounts.end());
+    shardCounts.erase(std::unique(shardCounts.begin(), shardCounts.end()), shardCounts.end());
+    for (size_t numShards : shardCounts) {
+        ShardedSimulator sim(numShards, numLines, numProducers);
+        start = std::chrono::steady_clock::now();
+        sim.replay(trace);
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        size_t writeBacks = 0, mismatches = 0;
+        uint64_t busiest = 0;
+        for (size_t s = 0; s < sim.getNumShards(); ++s) {
+            writeBacks += sim.getStats(s).l2WriteBacks;
+            busiest = std::max<uint64_t>(busiest, sim.getStats(s).simulatedMicros);
+        }
+        for (size_t line = 0; line < numLines; ++line) {
+            if (sim.getL2(sim.shardOf(line)).getLines()[sim.offsetInShard(line)].data != expected[line])
+                mismatches++;
+        }
+        std::cout << "  " << numShards << " shard(s): " << ms << " ms (" << lockedMs / ms << "x locked), "
+                  << writeBacks << " L2 write-backs, busiest shard " << busiest << " us simulated, "
+                  << mismatches << " lines differ from the locked replay\n";
+    }
+}
+
+static void printRunResult(const std::string &label, const RunResult &r) {
+    std::cout << "  " << label << ": " << r.operations << " ops, " << r.simulatedMicros << " us simulated, "
+              << r.flushes << " flushes (" << r.flushesElided << " elided), "
+              << r.mediaWrites << " media writes, " << r.wallMillis << " ms\n";
+}
+
+void runScaleOut(const std::string &tracePath) {
+    Config base = Config::loadFromFile("config.json");
+    std::vector<TraceOp> trace = tracePath.empty() ? generateTrace(16, 20000, 1 << 14, 42) : loadTrace(tracePath);
+    ProcessCoordinator coordinator(std::max(std::thread::hardware_concurrency(), 2u));
+    coordinator.shareTrace(trace);
+    std::cout << "Sharing " << trace.size() << " operations with " << coordinator.getNumWorkers()
+              << " worker processes\n";
+
+    std::vector<Config> configs;
+    for (size_t l1Size : {1024, 4096, 16384}) {
+        for (unsigned flushLatency : {50u, 100u}) {
+            Config cfg = base;
+            cfg.l1Size = l1Size;
+            cfg.flushLatency = flushLatency;
+            configs.push_back(cfg);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto outcomes = coordinator.runConfigs(configs);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Configurations (" << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms total):\n";
+    for (size_t i = 0; i < configs.size(); ++i) {
+        std::string label = "l1Size " + std::to_string(configs[i].l1Size) + ", flushLatency " +
+                            std::to_string(configs[i].flushLatency);
+        if (outcomes[i].completed)
+            printRunResult(label, outcomes[i].result);
+        else
+            std::cout << "  " << label << ": failed (signal " << outcomes[i].signal << ")\n";
+    }
+
+    size_t numShards = coordinator.getNumWorkers();
+    auto shardOutcomes = coordinator.runAddressShards(base, numShards);
+    std::cout << "Address shards of the base config:\n";
+    printRunResult(std::to_string(numShards) + " shards merged", mergeResults(shardOutcomes));
+    printRunResult("single process", runTraceSimulation(base, trace.data(), trace.size()));
+    auto &stats = coordinator.getStats();
+    std::cout << "Workers forked: " << stats.workersForked << ", crashed: " << stats.workersCrashed
+              << ", failed jobs: " << stats.jobsFailed << "\n";
+}
+
+void runSweep(const std::string &sweepPath) {
+    SweepSpec spec = SweepSpec::loadFromFile(sweepPath);
+    SweepRunner runner(spec);
+    std::cout << "Sweep " << sweepPath << ": " << runner.getPoints().size() << " points over";
+    for (const auto &axis : spec.axes)
+        std::cout << " " << axis.field << "(" << axis.values.size() << ")";
+    std::cout << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    auto rows = runner.run();
+    auto end = std::chrono::steady_clock::now();
+    size_t failed = 0, cached = 0;
+    double serialMillis = 0;
+    for (const auto &row : rows) {
+        if (row.cached)
+            cached++;
+        else if (!row.outcome.completed)
+            failed++;
+        else
+            serialMillis += row.outcome.result.wallMillis;
+    }
+    runner.writeResults(spec.output, rows);
+    std::cout << "Finished in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms (" << static_cast<long>(serialMillis) << " ms of runs), " << cached << " cached, " << failed
+              << " failed; wrote " << spec.output << std::endl;
+}
+
+// Misses of a fully associative LRU cache of `cacheLines` lines, simulated
+// directly; the per-size reference for the stack-distance pass.
+static uint64_t simulateLruMisses(const std::vector<TraceOp> &trace, size_t cacheLines) {
+    std::list<uint64_t> recency; // front = most recently used
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> position;
+    uint64_t missCount = 0;
+    for (const auto &op : trace) {
+        if (op.type == TraceOp::Type::Flush)
+            continue;
+        auto it = position.find(op.line);
+        if (it != position.end()) {
+            recency.splice(recency.begin(), recency, it->second);
+            continue;
+        }
+        missCount++;
+        if (recency.size() == cacheLines) {
+            position.erase(recency.back());
+            recency.pop_back();
+        }
+        recency.push_front(op.line);
+        position[op.line] = recency.begin();
+    }
+    return missCount;
+}
+
+void runMissRatioCurve(const std::string &tracePath) {
+    std::vector<TraceOp> trace = tracePath.empty() ? generateTrace(64, 20000, 1 << 16, 42) : loadTrace(tracePath);
+    std::vector<uint64_t> sizes;
+    for (uint64_t lines = 64; lines <= (1 << 16); lines *= 2)
+        sizes.push_back(lines);
+
+    auto start = std::chrono::steady_clock::now();
+    StackDistanceAnalyzer analyzer;
+    analyzer.processTrace(trace);
+    auto curve = analyzer.missRatioCurve(sizes);
+    auto end = std::chrono::steady_clock::now();
+    double passMs = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "Stack-distance pass: " << analyzer.getAccesses() << " accesses, " << analyzer.getDistinctLines()
+              << " distinct lines, " << passMs << " ms for " << sizes.size() << " cache sizes\n";
+
+    double simulatedMs = 0;
+    size_t mismatches = 0;
+    for (const auto &[lines, ratio] : curve) {
+        start = std::chrono::steady_clock::now();
+        uint64_t expected = simulateLruMisses(trace, lines);
+        end = std::chrono::steady_clock::now();
+        simulatedMs += std::chrono::duration<double, std::milli>(end - start).count();
+        if (expected != analyzer.misses(lines))
+            mismatches++;
+        std::cout << "  " << lines << " lines: miss ratio " << ratio << " (" << analyzer.misses(lines)
+                  << " misses, LRU simulation " << expected << ")\n";
+    }
+    std::cout << "One LRU simulation per size: " << simulatedMs << " ms; " << mismatches << " sizes disagree\n";
+}
+
+// Samples at a fixed rate and within a fixed number of tracked lines; either
+// is skipped when 0. The exact pass tracks every line, so it only runs when
+// asked for.
+void runSampledMissRatioCurve(const std::string &tracePath, double rate, size_t maxLines, bool compareExact) {
+    if (rate == 0.0 && maxLines == 0)
+        throw std::invalid_argument("SHARDS needs a sampling rate or a line budget");
+    std::vector<TraceOp> trace = tracePath.empty() ? generateTrace(64, 50000, 1 << 20, 42) : loadTrace(tracePath);
+    std::vector<uint64_t> sizes;
+    for (uint64_t lines = 1024; lines <= (1 << 21); lines *= 2)
+        sizes.push_back(lines);
+
+    struct Variant {
+        std::string name;
+        ShardsSampler sampler;
+    };
+    std::vector<Variant> variants;
+    if (rate > 0.0)
+        variants.push_back({"fixed rate " + std::to_string(rate), ShardsSampler(rate)});
+    if (maxLines > 0)
+        variants.push_back({"fixed size " + std::to_string(maxLines) + " lines", ShardsSampler(1.0, maxLines)});
+    std::vector<std::vector<std::pair<uint64_t, double>>> curves;
+    for (auto &variant : variants) {
+        auto start = std::chrono::steady_clock::now();
+        variant.sampler.processTrace(trace);
+        curves.push_back(variant.sampler.missRatioCurve(sizes));
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "SHARDS " << variant.name << ": " << variant.sampler.getSampledAccesses() << " sampled accesses, "
+                  << variant.sampler.getTrackedLines() << " lines tracked, final rate " << variant.sampler.getRate()
+                  << ", " << ms << " ms\n";
+    }
+
+    std::vector<std::pair<uint64_t, double>> exactCurve;
+    if (compareExact) {
+        auto start = std::chrono::steady_clock::now();
+        StackDistanceAnalyzer exact;
+        exact.processTrace(trace);
+        exactCurve = exact.missRatioCurve(sizes);
+        double exactMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Exact: " << exact.getAccesses() << " accesses, " << exact.getDistinctLines()
+                  << " lines tracked, " << exactMs << " ms\n";
+        for (size_t v = 0; v < variants.size(); ++v) {
+            MrcError error = compareMissRatioCurves(exactCurve, curves[v]);
+            std::cout << "  " << variants[v].name << ": miss-ratio error mean " << error.meanAbsolute << ", max "
+                      << error.maxAbsolute << "\n";
+        }
+    }
+
+    std::cout << "Cache lines" << (compareExact ? "  exact" : "");
+    for (const auto &variant : variants)
+        std::cout << "  " << variant.name;
+    std::cout << "\n";
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        std::cout << "  " << sizes[i] << ":";
+        if (compareExact)
+            std::cout << "  " << exactCurve[i].second;
+        for (const auto &curve : curves)
+            std::cout << "  " << curve[i].second;
+        std::cout << "\n";
+    }
+}
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <optional>
 #include <mutex>
+#include "huge_page_allocator.hpp"
 
 class VectorizedHashTable {
 public:
@@ -22,7 +23,7 @@ private:
         bool occupied;
     };
     size_t capacity;
-    std::vector<Bucket> table;
+    std::vector<Bucket, HugePageAllocator<Bucket>> table;
     std::mutex table_mutex;
     uint8_t fingerprint(uint64_t key) const;
     size_t index(uint64_t key) const;